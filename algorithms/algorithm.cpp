@@ -41,9 +41,29 @@ Algorithm::Algorithm(bool alterCurve, QObject *parent) :
 
 }
 
-void Algorithm::applyOnImage(Magick::Image &, bool)
+void Algorithm::applyOnImage(Magick::Image &image, bool hdr)
 {
-    dflWarning(tr("Algorithm::applyOnImage Not Implemented"));
+    if ( !isPointWise() ) {
+        dflWarning(tr("Algorithm::applyOnImage Not Implemented"));
+        return;
+    }
+    /* applyOnPixels() accepts aliased buffers, work in place */
+    image.modifyImage();
+    int h = image.rows(),
+            w = image.columns();
+    std::shared_ptr<FramePixels> pixel_cache(new FramePixels(image, true));
+    dfl_block bool error=false;
+    dfl_parallel_for(y, 0, h, 4, (), {
+        Magick::PixelPacket *pixels = pixel_cache->get(y,1);
+        if ( error || !pixels ) {
+            if ( !error )
+                dflError(DF_NULL_PIXELS);
+            error=true;
+            continue;
+        }
+        applyOnPixels(pixels, pixels, w, hdr);
+        pixel_cache->sync();
+    });
 }
 
 void Algorithm::applyOn(Photo &photo)
@@ -51,5 +71,39 @@ void Algorithm::applyOn(Photo &photo)
     bool hdr = photo.getScale() == Photo::HDR;
     applyOnImage(photo.image(), hdr);
     if (m_alterCurve)
+        applyOnCurve(photo, hdr);
+    applyOnTags(photo);
+}
+
+void Algorithm::applyOnCurve(Photo &photo, bool hdr)
+{
+    std::shared_ptr<const quantum_t> lut = channelLut(hdr);
+    if ( lut )
+        photo.composeCurve(lut);
+    else
         applyOnImage(photo.curve(), hdr);
 }
+
+std::shared_ptr<const quantum_t> Algorithm::channelLut(bool) const
+{
+    return std::shared_ptr<const quantum_t>();
+}
+
+bool Algorithm::isPointWise() const
+{
+    return false;
+}
+
+void Algorithm::applyOnPixels(const Magick::PixelPacket *, Magick::PixelPacket *, int, bool)
+{
+    dflWarning(tr("Algorithm::applyOnPixels Not Implemented"));
+}
+
+void Algorithm::applyOnTags(Photo &)
+{
+}
+
+bool Algorithm::altersCurve() const
+{
+    return m_alterCurve;
+}
@@ -32,6 +32,8 @@
 #define MANIPULATION_H
 
 #include <QObject>
+#include <Magick++.h>
+#include <memory>
 
 
 template<typename t> t clamp(t v,t min = 0, t max = 65535 /* ARgg! */ ) {
@@ -43,10 +45,7 @@ template<typename t> t clamp(t v,t min = 0, t max = 65535 /* ARgg! */ ) {
     return v;
 }
 
-class Photo;
-namespace Magick {
-class Image;
-}
+#include "photo.h"
 
 class Algorithm : public QObject
 {
@@ -56,6 +55,36 @@ public:
 
     virtual void applyOnImage(Magick::Image& image, bool hdr);
     virtual void applyOn(Photo& photo);
+    /**
+     * @brief applyOnCurve called when the algorithm alters the curve,
+     * a channel look-up table is composed on it, otherwise the curve
+     * image is processed like any other image
+     */
+    virtual void applyOnCurve(Photo& photo, bool hdr);
+    /**
+     * @brief channelLut
+     * @return the QuantumRange+1 entries table applied on each channel
+     * independently, or NULL if the algorithm is not such a table
+     */
+    virtual std::shared_ptr<const quantum_t> channelLut(bool hdr) const;
+
+    /**
+     * @brief isPointWise
+     * @return true if the algorithm implements applyOnPixels(), i.e. each
+     * output pixel only depends on the input pixel at the same position
+     */
+    virtual bool isPointWise() const;
+    /**
+     * @brief applyOnPixels process count pixels, src and dst may alias
+     */
+    virtual void applyOnPixels(const Magick::PixelPacket *src,
+                               Magick::PixelPacket *dst,
+                               int count, bool hdr);
+    /**
+     * @brief applyOnTags called by applyOn() once the pixels are processed
+     */
+    virtual void applyOnTags(Photo& photo);
+    bool altersCurve() const;
 
 signals:
 
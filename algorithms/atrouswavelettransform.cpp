@@ -167,7 +167,7 @@ Photo ATrousWaveletTransform::transform(int n, int nPlanes, Photo::Gamma scale,
                          cSign->sync();
                          cPlane->sync();
                      });
-    if (!lastPlane)
+    if (!lastPlane && !DfCancellation::requested())
         for (int i=0, s = m_w*m_h ; i < s ; ++i)
             m_image[i] = m_tmp[i];
     plane.setIdentity(m_identity+QString(":W:%0").arg(n+1));
@@ -43,43 +43,32 @@ ChannelMixer::ChannelMixer(qreal r, qreal g, qreal b, QObject *parent) :
     m_rgb[2] = b;
 }
 
-void ChannelMixer::applyOnImage(Magick::Image &image, bool hdr)
+bool ChannelMixer::isPointWise() const
 {
-    Magick::Image srcImage(image);
-    ResetImage(image);
-    int h = image.rows(),
-            w = image.columns();
-    std::shared_ptr<Ordinary::Pixels> src_cache(new Ordinary::Pixels(srcImage));
-    std::shared_ptr<Ordinary::Pixels> pixel_cache(new Ordinary::Pixels(image));
-    dfl_block bool error=false;
-    dfl_parallel_for(y, 0, h, 4, (srcImage, image), {
-        Magick::PixelPacket *pixels = pixel_cache->get(0,y,w,1);
-        const Magick::PixelPacket *src = src_cache->getConst(0,y,w,1);
-        if ( error || !pixels || !src ) {
-            if ( !error )
-                dflError(DF_NULL_PIXELS);
-            error=true;
-            continue;
+    return true;
+}
+
+void ChannelMixer::applyOnPixels(const Magick::PixelPacket *src,
+                                 Magick::PixelPacket *dst,
+                                 int count, bool hdr)
+{
+    for (int x = 0 ; x < count ; ++x ) {
+        using Magick::Quantum;
+        if (hdr) {
+            dst[x].red=
+            dst[x].green=
+            dst[x].blue=clamp<quantum_t>(
+                        toHDR(m_rgb[0]*fromHDR(src[x].red) +
+                              m_rgb[1]*fromHDR(src[x].green) +
+                              m_rgb[2]+fromHDR(src[x].blue)));
         }
-        for (int x = 0 ; x < w ; ++x ) {
-            using Magick::Quantum;
-            if (hdr) {
-                pixels[x].red=
-                pixels[x].green=
-                pixels[x].blue=clamp<quantum_t>(
-                            toHDR(m_rgb[0]*fromHDR(src[x].red) +
-                                  m_rgb[1]*fromHDR(src[x].green) +
-                                  m_rgb[2]+fromHDR(src[x].blue)));
-            }
-            else {
-                pixels[x].red=
-                pixels[x].green=
-                pixels[x].blue=clamp<quantum_t>(
-                            DF_ROUND(m_rgb[0]*src[x].red +
-                                     m_rgb[1]*src[x].green +
-                                     m_rgb[2]*src[x].blue));
-            }
+        else {
+            dst[x].red=
+            dst[x].green=
+            dst[x].blue=clamp<quantum_t>(
+                        DF_ROUND(m_rgb[0]*src[x].red +
+                                 m_rgb[1]*src[x].green +
+                                 m_rgb[2]*src[x].blue));
         }
-        pixel_cache->sync();
-    });
+    }
 }
@@ -42,7 +42,10 @@ public:
                  qreal g = LUMINANCE_GREEN,
                  qreal b = LUMINANCE_BLUE,
                  QObject *parent = 0);
-    void applyOnImage(Magick::Image& image, bool hdr);
+    bool isPointWise() const;
+    void applyOnPixels(const Magick::PixelPacket *src,
+                       Magick::PixelPacket *dst,
+                       int count, bool hdr);
 
 private:
     qreal m_rgb[3];
@@ -43,48 +43,35 @@ ColorFilter::ColorFilter(qreal r, qreal g, qreal b, QObject *parent) :
     m_rgb[2] = b;
 }
 
-void ColorFilter::applyOnImage(Magick::Image &image, bool hdr)
+bool ColorFilter::isPointWise() const
 {
-    Magick::Image srcImage(image);
-    ResetImage(image);
-    int h = image.rows(),
-            w = image.columns();
-    std::shared_ptr<Ordinary::Pixels> src_cache(new Ordinary::Pixels(srcImage));
-    std::shared_ptr<Ordinary::Pixels> pixel_cache(new Ordinary::Pixels(image));
-    dfl_block_array(qreal, rgb, 3);
+    return true;
+}
+
+void ColorFilter::applyOnPixels(const Magick::PixelPacket *src,
+                                Magick::PixelPacket *dst,
+                                int count, bool hdr)
+{
+    using Magick::Quantum;
+    qreal rgb[3];
     if (hdr) {
         rgb[0] = log2(m_rgb[0])*4096;
         rgb[1] = log2(m_rgb[1])*4096;
         rgb[2] = log2(m_rgb[2])*4096;
+        for (int x = 0 ; x < count ; ++x ) {
+            dst[x].red=clamp<double>(src[x].red+rgb[0],0,QuantumRange);
+            dst[x].green=clamp<double>(src[x].green+rgb[1],0,QuantumRange);
+            dst[x].blue=clamp<double>(src[x].blue+rgb[2],0,QuantumRange);
+        }
     }
     else {
         rgb[0] = m_rgb[0];
         rgb[1] = m_rgb[1];
         rgb[2] = m_rgb[2];
-    }
-    dfl_block bool error=false;
-    dfl_parallel_for(y, 0, h, 4, (image, srcImage), {
-        Magick::PixelPacket *pixels = pixel_cache->get(0,y,w,1);
-        const Magick::PixelPacket *src = src_cache->getConst(0,y,w,1);
-        if ( error || !pixels || !src ) {
-            if (!error)
-                dflError(DF_NULL_PIXELS);
-            error=true;
-            continue;
-        }
-        for (int x = 0 ; x < w ; ++x ) {
-            using Magick::Quantum;
-            if (hdr) {
-                pixels[x].red=clamp<double>(src[x].red+rgb[0],0,QuantumRange);
-                pixels[x].green=clamp<double>(src[x].green+rgb[1],0,QuantumRange);
-                pixels[x].blue=clamp<double>(src[x].blue+rgb[2],0,QuantumRange);
-            }
-            else {
-                pixels[x].red=clamp<double>(src[x].red*rgb[0],0,QuantumRange);
-                pixels[x].green=clamp<double>(src[x].green*rgb[1],0,QuantumRange);
-                pixels[x].blue=clamp<double>(src[x].blue*rgb[2],0,QuantumRange);
-            }
+        for (int x = 0 ; x < count ; ++x ) {
+            dst[x].red=clamp<double>(src[x].red*rgb[0],0,QuantumRange);
+            dst[x].green=clamp<double>(src[x].green*rgb[1],0,QuantumRange);
+            dst[x].blue=clamp<double>(src[x].blue*rgb[2],0,QuantumRange);
         }
-        pixel_cache->sync();
-    });
+    }
 }
@@ -41,7 +41,10 @@ public:
                          qreal g,
                          qreal b,
                          QObject *parent = 0);
-    void applyOnImage(Magick::Image& image, bool hdr);
+    bool isPointWise() const;
+    void applyOnPixels(const Magick::PixelPacket *src,
+                       Magick::PixelPacket *dst,
+                       int count, bool hdr);
 
 private:
     qreal m_rgb[3];
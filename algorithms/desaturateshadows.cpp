@@ -71,64 +71,51 @@ DesaturateShadows::~DesaturateShadows()
     delete[] m_lut;
 }
 
-void DesaturateShadows::applyOnImage(Magick::Image& image, bool hdr)
+bool DesaturateShadows::isPointWise() const
 {
-    Magick::Image srcImage(image);
-    ResetImage(image);
-    int h = image.rows(),
-            w = image.columns();
+    return true;
+}
 
-    std::shared_ptr<Ordinary::Pixels> src_cache(new Ordinary::Pixels(srcImage));
-    std::shared_ptr<Ordinary::Pixels> pixel_cache(new Ordinary::Pixels(image));
-    dfl_block bool error=false;
-    dfl_parallel_for(y, 0, h, 4, (image, srcImage), {
-        Magick::PixelPacket *pixels = pixel_cache->get(0,y,w,1);
-        const Magick::PixelPacket *src = src_cache->getConst(0,y,w,1);
-        if ( error || !pixels || !src ) {
-            if ( !error )
-                dflError(DF_NULL_PIXELS);
-            error=true;
-            continue;
+void DesaturateShadows::applyOnPixels(const Magick::PixelPacket *src,
+                                      Magick::PixelPacket *dst,
+                                      int count, bool hdr)
+{
+    for ( int x = 0 ; x < count ; ++x ) {
+        double rgb[3];
+        if (hdr) {
+            rgb[0]=fromHDR(src[x].red);
+            rgb[1]=fromHDR(src[x].green);
+            rgb[2]=fromHDR(src[x].blue);
+        }
+        else {
+            rgb[0]=src[x].red;
+            rgb[1]=src[x].green;
+            rgb[2]=src[x].blue;
         }
-        for ( int x = 0 ; x < w ; ++x ) {
-            double rgb[3];
+        double lab[3];
+        RGB_to_LinearLab(rgb,lab);
+        quantum_t L= DF_ROUND(lab[0]*QuantumRange);
+        if ( L > QuantumRange ) L=QuantumRange;
+        if ( ! DF_EQUALS(m_lut[L],1.,.00001) )
+        {
+            lab[1]*=m_lut[L];
+            lab[2]*=m_lut[L];
+            LinearLab_to_RGB(lab,rgb);
             if (hdr) {
-                rgb[0]=fromHDR(src[x].red);
-                rgb[1]=fromHDR(src[x].green);
-                rgb[2]=fromHDR(src[x].blue);
+                dst[x].red = toHDR(rgb[0]);
+                dst[x].green = toHDR(rgb[1]);
+                dst[x].blue = toHDR(rgb[2]);
             }
             else {
-                rgb[0]=src[x].red;
-                rgb[1]=src[x].green;
-                rgb[2]=src[x].blue;
-            }
-            double lab[3];
-            RGB_to_LinearLab(rgb,lab);
-            quantum_t L= DF_ROUND(lab[0]*QuantumRange);
-            if ( L > QuantumRange ) L=QuantumRange;
-            if ( ! DF_EQUALS(m_lut[L],1.,.00001) )
-            {
-                lab[1]*=m_lut[L];
-                lab[2]*=m_lut[L];
-                LinearLab_to_RGB(lab,rgb);
-                if (hdr) {
-                    pixels[x].red = toHDR(rgb[0]);
-                    pixels[x].green = toHDR(rgb[1]);
-                    pixels[x].blue = toHDR(rgb[2]);
-                }
-                else {
-                    pixels[x].red = DF_ROUND(rgb[0]);
-                    pixels[x].green = DF_ROUND(rgb[1]);
-                    pixels[x].blue = DF_ROUND(rgb[2]);
-                }
-            }
-            else {
-                pixels[x].red = src[x].red;
-                pixels[x].green = src[x].green;
-                pixels[x].blue = src[x].blue;
+                dst[x].red = DF_ROUND(rgb[0]);
+                dst[x].green = DF_ROUND(rgb[1]);
+                dst[x].blue = DF_ROUND(rgb[2]);
             }
         }
-        pixel_cache->sync();
-    });
+        else {
+            dst[x].red = src[x].red;
+            dst[x].green = src[x].green;
+            dst[x].blue = src[x].blue;
+        }
+    }
 }
-
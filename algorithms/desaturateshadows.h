@@ -49,7 +49,10 @@ public:
                                qreal saturation,
                                QObject *parent = 0);
     ~DesaturateShadows();
-    void applyOnImage(Magick::Image& image, bool hdr);
+    bool isPointWise() const;
+    void applyOnPixels(const Magick::PixelPacket *src,
+                       Magick::PixelPacket *dst,
+                       int count, bool hdr);
 private:
     double *m_lut;
     qreal m_highlightLimit;
@@ -57,13 +57,16 @@ DiscreteFourierTransform::DiscreteFourierTransform(Magick::Image &image, Photo::
       blue(reinterpret_cast<std::complex<double>*>(fftw_alloc_complex(m_h*m_w)))
 {
 #ifndef ANDROID
-    fftw_plan_with_nthreads(preferences->getNumThreads());
+    DfThreads threads(DfThreadLimit());
+    fftw_plan_with_nthreads(threads.count());
 #endif
     std::complex<double> *input = reinterpret_cast<std::complex<double>*>(fftw_alloc_complex(m_h*m_w));
     //std::complex<double> *output = reinterpret_cast<std::complex<double>*>(fftw_alloc_complex(m_h*m_w));
     Ordinary::Pixels cache(image);
     const Magick::PixelPacket *pixels = cache.getConst(0, 0, m_w, m_h);
     for (int c = 0 ; c < 3 ; ++c ) {
+        if ( DfCancellation::requested() )
+            break;
         for ( int y = 0 ; y < m_h ; ++y ) {
             for ( int x = 0 ; x < m_w ; ++x ) {
                 quantum_t p = 0;
@@ -145,6 +148,10 @@ DiscreteFourierTransform::~DiscreteFourierTransform()
 
 Magick::Image DiscreteFourierTransform::reverse(double luminosity, ReverseType type)
 {
+#ifndef ANDROID
+    DfThreads threads(DfThreadLimit());
+    fftw_plan_with_nthreads(threads.count());
+#endif
     Magick::Image image(Magick::Geometry(m_w, m_h), Magick::Color(0, 0, 0));
     image.modifyImage();
     Ordinary::Pixels cache(image);
@@ -152,6 +159,8 @@ Magick::Image DiscreteFourierTransform::reverse(double luminosity, ReverseType t
     std::complex<double> *input = reinterpret_cast<std::complex<double>*>(fftw_alloc_complex(m_h*m_w));
     std::complex<double> *output = reinterpret_cast<std::complex<double>*>(fftw_alloc_complex(m_h*m_w));
     for ( int c = 0 ; c < 3 ; ++c ) {
+        if ( DfCancellation::requested() )
+            break;
         std::complex<double> *plane = 0;
         switch(c) {
         case 0: plane = red; break;
@@ -72,12 +72,8 @@ HDR::HDR(bool revert, QObject *parent) :
     });
 }
 
-void HDR::applyOn(Photo &photo)
+void HDR::applyOnTags(Photo &photo)
 {
-    bool hdr = photo.getScale() == Photo::HDR;
-    applyOnImage(photo.image(), hdr);
-    if (m_alterCurve)
-        applyOnImage(photo.curve(), hdr);
     photo.setTag(TAG_SCALE,
                  m_revert
                  ? TAG_SCALE_LINEAR
@@ -60,7 +60,7 @@ class HDR : public LutBased
     Q_OBJECT
 public:
     HDR(bool revert, QObject *parent = 0);
-    void applyOn(Photo &photo);
+    void applyOnTags(Photo &photo);
 private:
     bool m_revert;
 };
@@ -30,6 +30,8 @@
  */
 #include "hotpixels.h"
 #include <Magick++.h>
+#include <algorithm>
+#include <vector>
 #include "hdr.h"
 #include "console.h"
 using Magick::Quantum;
@@ -91,86 +93,141 @@ HotPixels::HotPixels(double delta, bool aggressive, bool naive, QObject *parent)
     if ( sum_rgb[q]*m_delta < rgb[q] ) rgb[q]=sum_rgb[q]; \
     if ( sum_rgb[q]/m_delta > rgb[q] ) rgb[q]=sum_rgb[q];
 
+/* rows of a band, the band borders are saved before filtering */
+#define DF_HOTPIXELS_BAND 32
+
 void HotPixels::applyOnImage(Magick::Image &image, bool hdr)
 {
-    Magick::Image input(image);
-    ResetImage(image);
-
-    std::shared_ptr<Ordinary::Pixels>
-            output_cache(new Ordinary::Pixels(image)),
-            input_cache(new Ordinary::Pixels(input));
+    /*
+     * Filtered in place: each band walks its rows keeping the original
+     * rows above, at and below the current one in a ring of three, so
+     * only the rows bordering the other bands need to be saved.
+     */
+    image.modifyImage();
+    std::shared_ptr<Ordinary::Pixels> cache(new Ordinary::Pixels(image));
 
     int w = image.columns();
     int h = image.rows();
+    if ( w < 3 || h < 3 )
+        return;
+    int n_bands = (h - 2 + DF_HOTPIXELS_BAND - 1) / DF_HOTPIXELS_BAND;
+    std::shared_ptr<std::vector<Magick::PixelPacket> >
+            borders(new std::vector<Magick::PixelPacket>(size_t(n_bands) * 2 * w));
+    for ( int b = 0 ; b < n_bands ; ++b ) {
+        int y0 = 1 + b * DF_HOTPIXELS_BAND;
+        int y1 = qMin(h - 1, y0 + DF_HOTPIXELS_BAND);
+        const Magick::PixelPacket *above = cache->getConst(0, y0 - 1, w, 1);
+        if ( !above ) {
+            dflError(DF_NULL_PIXELS);
+            return;
+        }
+        std::copy(above, above + w, borders->begin() + size_t(2 * b) * w);
+        const Magick::PixelPacket *below = cache->getConst(0, y1, w, 1);
+        if ( !below ) {
+            dflError(DF_NULL_PIXELS);
+            return;
+        }
+        std::copy(below, below + w, borders->begin() + size_t(2 * b + 1) * w);
+    }
+
     dfl_block bool error=false;
-    dfl_parallel_for(y, 1, h-1, 4, (input, image), {
-        Magick::PixelPacket *output_pixels = output_cache->get(0,y,w,1);
-        const Magick::PixelPacket *input_pixels[3];
-        input_pixels[0] = input_cache->getConst(0,y-1,w,1);
-        input_pixels[1] = input_cache->getConst(0,y,w,1);
-        input_pixels[2] = input_cache->getConst(0,y+1,w,1);
-        if ( error || !output_pixels || !input_pixels[0] || !input_pixels[1] || !input_pixels[2] ) {
+    dfl_parallel_for(b, 0, n_bands, 1, (image), {
+        int y0 = 1 + b * DF_HOTPIXELS_BAND;
+        int y1 = qMin(h - 1, y0 + DF_HOTPIXELS_BAND);
+        std::vector<Magick::PixelPacket> ring(size_t(3) * w);
+        Magick::PixelPacket *rows[3] = { &ring[0], &ring[w], &ring[2 * w] };
+        const Magick::PixelPacket *current = cache->getConst(0, y0, w, 1);
+        if ( error || !current ) {
             if (!error)
                 dflError(DF_NULL_PIXELS);
             error=true;
             continue;
         }
-        for ( int x = 1 ; x < w-1 ; ++x ) {
-            extended_quantum_t max_rgb[3]={0,0,0};
-            extended_quantum_t min_rgb[3]={QuantumRange,QuantumRange,QuantumRange};
-            extended_quantum_t sum_rgb[3]={0,0,0};
-            extended_quantum_t rgb[3];
-            extended_quantum_t nrgb[3];
-            extended_quantum_t other_channels=0;
-
-            if (hdr) {
-                rgb[0]=DF_ROUND(fromHDR(input_pixels[1][x].red));
-                rgb[1]=DF_ROUND(fromHDR(input_pixels[1][x].green));
-                rgb[2]=DF_ROUND(fromHDR(input_pixels[1][x].blue));
-            }
-            else {
-                rgb[0]=input_pixels[1][x].red;
-                rgb[1]=input_pixels[1][x].green;
-                rgb[2]=input_pixels[1][x].blue;
+        std::copy(current, current + w, rows[1]);
+        const Magick::PixelPacket *above = &(*borders)[size_t(2 * b) * w];
+        std::copy(above, above + w, rows[0]);
+        for ( int y = y0 ; y < y1 && !error ; ++y ) {
+            /* saved before row y is written, the views may be reused */
+            const Magick::PixelPacket *below = ( y + 1 == y1 )
+                    ? &(*borders)[size_t(2 * b + 1) * w]
+                    : cache->getConst(0, y + 1, w, 1);
+            if ( below )
+                std::copy(below, below + w, rows[2]);
+            Magick::PixelPacket *output_pixels = below ? cache->get(0, y, w, 1) : NULL;
+            if ( !below || !output_pixels ) {
+                dflError(DF_NULL_PIXELS);
+                error=true;
+                break;
             }
+            const Magick::PixelPacket *input_pixels[3] = { rows[0], rows[1], rows[2] };
+            applyOnRow(input_pixels, output_pixels, w, hdr);
+            cache->sync();
+            Magick::PixelPacket *recycled = rows[0];
+            rows[0] = rows[1];
+            rows[1] = rows[2];
+            rows[2] = recycled;
+        }
+    });
+}
+
+void HotPixels::applyOnRow(const Magick::PixelPacket *input_pixels[3],
+                           Magick::PixelPacket *output_pixels,
+                           int w, bool hdr)
+{
+    for ( int x = 1 ; x < w-1 ; ++x ) {
+        extended_quantum_t max_rgb[3]={0,0,0};
+        extended_quantum_t min_rgb[3]={QuantumRange,QuantumRange,QuantumRange};
+        extended_quantum_t sum_rgb[3]={0,0,0};
+        extended_quantum_t rgb[3];
+        extended_quantum_t nrgb[3];
+        extended_quantum_t other_channels=0;
+
+        if (hdr) {
+            rgb[0]=DF_ROUND(fromHDR(input_pixels[1][x].red));
+            rgb[1]=DF_ROUND(fromHDR(input_pixels[1][x].green));
+            rgb[2]=DF_ROUND(fromHDR(input_pixels[1][x].blue));
+        }
+        else {
+            rgb[0]=input_pixels[1][x].red;
+            rgb[1]=input_pixels[1][x].green;
+            rgb[2]=input_pixels[1][x].blue;
+        }
 
 
-            if ( m_naive ) {
-                loop_code_naive(-1,-1); loop_code_naive(-1, 0); loop_code_naive(-1, 1);
-                loop_code_naive( 0,-1);                         loop_code_naive( 0, 1);
-                loop_code_naive( 1,-1); loop_code_naive( 1, 0); loop_code_naive( 1, 1);
+        if ( m_naive ) {
+            loop_code_naive(-1,-1); loop_code_naive(-1, 0); loop_code_naive(-1, 1);
+            loop_code_naive( 0,-1);                         loop_code_naive( 0, 1);
+            loop_code_naive( 1,-1); loop_code_naive( 1, 0); loop_code_naive( 1, 1);
 
-                if ( m_aggressive ) {
-                    color_op2_naive_aggressive(0); color_op2_naive_aggressive(1); color_op2_naive_aggressive(2);
-                }
-                else {
-                    color_op2_naive(0); color_op2_naive(1); color_op2_naive(2);
-                }
+            if ( m_aggressive ) {
+                color_op2_naive_aggressive(0); color_op2_naive_aggressive(1); color_op2_naive_aggressive(2);
             }
             else {
-                loop_code(-1,-1); loop_code(-1, 0); loop_code(-1, 1);
-                loop_code( 0,-1);                   loop_code( 0, 1);
-                loop_code( 1,-1); loop_code( 1, 0); loop_code( 1, 1);
-
-                if ( m_aggressive ) {
-                    color_op2_aggressive(0); color_op2_aggressive(1); color_op2_aggressive(2);
-                }
-                else {
-                    color_op2(0); color_op2(1); color_op2(2);
-                }
+                color_op2_naive(0); color_op2_naive(1); color_op2_naive(2);
             }
+        }
+        else {
+            loop_code(-1,-1); loop_code(-1, 0); loop_code(-1, 1);
+            loop_code( 0,-1);                   loop_code( 0, 1);
+            loop_code( 1,-1); loop_code( 1, 0); loop_code( 1, 1);
 
-            if (hdr) {
-                output_pixels[x].red=toHDR(rgb[0]>QuantumRange?QuantumRange:rgb[0]);
-                output_pixels[x].green=toHDR(rgb[1]>QuantumRange?QuantumRange:rgb[1]);
-                output_pixels[x].blue=toHDR(rgb[2]>QuantumRange?QuantumRange:rgb[2]);
+            if ( m_aggressive ) {
+                color_op2_aggressive(0); color_op2_aggressive(1); color_op2_aggressive(2);
             }
             else {
-                output_pixels[x].red=rgb[0]>QuantumRange?QuantumRange:rgb[0];
-                output_pixels[x].green=rgb[1]>QuantumRange?QuantumRange:rgb[1];
-                output_pixels[x].blue=rgb[2]>QuantumRange?QuantumRange:rgb[2];
+                color_op2(0); color_op2(1); color_op2(2);
             }
         }
-        output_cache->sync();
-    });
+
+        if (hdr) {
+            output_pixels[x].red=toHDR(rgb[0]>QuantumRange?QuantumRange:rgb[0]);
+            output_pixels[x].green=toHDR(rgb[1]>QuantumRange?QuantumRange:rgb[1]);
+            output_pixels[x].blue=toHDR(rgb[2]>QuantumRange?QuantumRange:rgb[2]);
+        }
+        else {
+            output_pixels[x].red=rgb[0]>QuantumRange?QuantumRange:rgb[0];
+            output_pixels[x].green=rgb[1]>QuantumRange?QuantumRange:rgb[1];
+            output_pixels[x].blue=rgb[2]>QuantumRange?QuantumRange:rgb[2];
+        }
+    }
 }
@@ -41,6 +41,14 @@ public:
     HotPixels(double delta, bool aggressive, bool  naive, QObject *parent = 0);
     void applyOnImage(Magick::Image &image, bool hdr);
 private:
+    /**
+     * @brief applyOnRow filters the row input_pixels[1] into output_pixels
+     * @param input_pixels the original rows above, at, and below
+     */
+    void applyOnRow(const Magick::PixelPacket *input_pixels[3],
+                    Magick::PixelPacket *output_pixels,
+                    int w, bool hdr);
+
     double m_delta;
     bool m_aggressive;
     bool m_naive;
@@ -123,12 +123,8 @@ iGamma& iGamma::reverse_Lab()
     return g;
 }
 
-void iGamma::applyOn(Photo &photo)
+void iGamma::applyOnTags(Photo &photo)
 {
-    bool hdr = photo.getScale() == Photo::HDR;
-    applyOnImage(photo.image(), hdr);
-    if (m_alterCurve)
-        applyOnImage(photo.curve(), hdr);
     photo.setTag(TAG_SCALE,
                  m_invert
                  ? TAG_SCALE_LINEAR
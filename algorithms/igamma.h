@@ -49,7 +49,7 @@ public:
     static iGamma& reverse_BT709();
     static iGamma& reverse_Lab();
 
-    void applyOn(Photo &photo);
+    void applyOnTags(Photo &photo);
 
 private:
     qreal m_gamma;
@@ -37,44 +37,50 @@ using Magick::Quantum;
 LutBased::LutBased(QObject *parent) :
     Algorithm(true, parent),
     m_lut(new quantum_t[QuantumRange+1]),
-    m_hdrLut(new quantum_t[QuantumRange+1])
+    m_hdrLut(new quantum_t[QuantumRange+1]),
+    m_lutTable(m_lut, std::default_delete<quantum_t[]>()),
+    m_hdrLutTable(m_hdrLut, std::default_delete<quantum_t[]>())
 {
 
 }
 
 LutBased::~LutBased()
 {
-    delete[] m_hdrLut;
-    delete[] m_lut;
 }
 
-void LutBased::applyOnImage(Magick::Image &image, bool hdr)
+bool LutBased::isPointWise() const
 {
-    Magick::Image srcImage(image);
-    ResetImage(image);
-    quantum_t *lut = hdr ? m_hdrLut : m_lut;
-    int h = image.rows(),
-            w = image.columns();
-    std::shared_ptr<Ordinary::Pixels> src_cache(new Ordinary::Pixels(srcImage));
-    std::shared_ptr<Ordinary::Pixels> pixel_cache(new Ordinary::Pixels(image));
-    dfl_block bool error=false;
-    dfl_parallel_for(y, 0, h, 4, (image, srcImage), {
-                     Magick::PixelPacket *pixels = pixel_cache->get(0,y,w,1);
-                     const Magick::PixelPacket *src = src_cache->getConst(0,y,w,1);
-                     if ( error || !pixels || !src ) {
-                         if ( !error )
-                         dflError(DF_NULL_PIXELS);
-                         error=true;
-                         continue;
-                     }
-                     for ( int x = 0 ; x < w ; ++x ) {
-                         pixels[x].red=lut[src[x].red];
-                         pixels[x].green=lut[src[x].green];
-                         pixels[x].blue=lut[src[x].blue];
-                     }
-                     pixel_cache->sync();
+    return true;
+}
+
+void LutBased::applyOnPixels(const Magick::PixelPacket *src,
+                             Magick::PixelPacket *dst,
+                             int count, bool hdr)
+{
+    applyLut(hdr ? m_hdrLut : m_lut, src, dst, count);
+}
 
-                 });
+std::shared_ptr<const quantum_t> LutBased::channelLut(bool hdr) const
+{
+    return hdr ? m_hdrLutTable : m_lutTable;
+}
+
+void LutBased::applyLut(const quantum_t *lut,
+                        const Magick::PixelPacket *src,
+                        Magick::PixelPacket *dst,
+                        int count)
+{
+    for ( int x = 0 ; x < count ; ++x ) {
+        dst[x].red=lut[src[x].red];
+        dst[x].green=lut[src[x].green];
+        dst[x].blue=lut[src[x].blue];
+    }
+}
+
+void LutBased::compose(quantum_t *lut, const quantum_t *table)
+{
+    for ( int i = 0 ; i <= QuantumRange ; ++i )
+        lut[i] = table[clamp(lut[i])];
 }
 
 quantum_t LutBased::applyOnQuantum(quantum_t v, bool hdr)
@@ -32,6 +32,7 @@
 #define LUTBASED_H
 
 #include <QObject>
+#include <memory>
 #include "algorithm.h"
 #include "photo.h"
 
@@ -43,12 +44,33 @@ public:
     explicit LutBased(QObject *parent = 0);
     ~LutBased();
 
-    void applyOnImage(Magick::Image& image, bool hdr);
+    bool isPointWise() const;
+    void applyOnPixels(const Magick::PixelPacket *src,
+                       Magick::PixelPacket *dst,
+                       int count, bool hdr);
     quantum_t applyOnQuantum(quantum_t v, bool hdr);
+    std::shared_ptr<const quantum_t> channelLut(bool hdr) const;
+
+    /**
+     * @brief applyLut applies the same table on the three channels
+     */
+    static void applyLut(const quantum_t *lut,
+                         const Magick::PixelPacket *src,
+                         Magick::PixelPacket *dst,
+                         int count);
+    /**
+     * @brief compose folds table after lut, lut[i] becomes table[lut[i]]
+     */
+    static void compose(quantum_t *lut, const quantum_t *table);
 
 protected:
+    /* filled by the constructors, read-only afterwards since the
+     * tables are shared with the curves they are composed on */
     quantum_t *m_lut;
     quantum_t *m_hdrLut;
+private:
+    std::shared_ptr<const quantum_t> m_lutTable;
+    std::shared_ptr<const quantum_t> m_hdrLutTable;
 };
 
 #endif // LUTBASED_H
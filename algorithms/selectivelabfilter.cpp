@@ -58,9 +58,7 @@ void SelectiveLabFilter::applyOnImage(Magick::Image &image, bool hdr)
 {
     int     h = image.rows(),
             w = image.columns();
-    Magick::Image srcImage(image);
-    ResetImage(image);
-    std::shared_ptr<Ordinary::Pixels> src_cache(new Ordinary::Pixels(srcImage));
+    image.modifyImage();
     std::shared_ptr<Ordinary::Pixels> pixel_cache(new Ordinary::Pixels(image));
 
     double saturation = m_saturation;
@@ -103,10 +101,11 @@ void SelectiveLabFilter::applyOnImage(Magick::Image &image, bool hdr)
     theta = M_PI * double((360+m_hue)%360)/180.;
 
     dfl_block bool error = false;
-    dfl_parallel_for(y, 0, h, 4, (image, srcImage), {
-        const Magick::PixelPacket *src = src_cache->getConst(0,y,w,1);
+    dfl_parallel_for(y, 0, h, 4, (image), {
         Magick::PixelPacket *pixels = pixel_cache->get(0,y,w,1);
-        if ( error || !src || !pixels ) {
+        /* each pixel is read before it is written */
+        const Magick::PixelPacket *src = pixels;
+        if ( error || !pixels ) {
             if ( !error )
                 dflError(DF_NULL_PIXELS);
             error = true;
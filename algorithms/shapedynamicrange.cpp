@@ -112,69 +112,60 @@ ShapeDynamicRange::ShapeDynamicRange(ShapeDynamicRange::Shape shape, qreal dynam
     //valable pour plage dynamique <= 13 car au delà, la courbe est toujours sup
 }
 
-void ShapeDynamicRange::applyOnImage(Magick::Image& image, bool hdr)
+void ShapeDynamicRange::applyOnPixels(const Magick::PixelPacket *src,
+                                      Magick::PixelPacket *dst,
+                                      int count, bool hdr)
 {
-    Magick::Image srcImage(image);
-    ResetImage(image);
-    int h = image.rows(),
-            w = image.columns();
-
-    std::shared_ptr<Ordinary::Pixels> src_cache(new Ordinary::Pixels(srcImage));
-    std::shared_ptr<Ordinary::Pixels> pixel_cache(new Ordinary::Pixels(image));
-    dfl_block bool error=false;
-    dfl_parallel_for(y, 0, h, 4, (image, srcImage), {
-        Magick::PixelPacket *pixels = pixel_cache->get(0,y,w,1);
-        const Magick::PixelPacket *src = src_cache->getConst(0,y,w,1);
-        if ( error || ! pixels || !src ) {
-            if (!error)
-                dflError(DF_NULL_PIXELS);
-            error=true;
-            continue;
+    for (int x = 0 ; x < count ; ++x ) {
+        quantum_t rgb[3];
+        rgb[0] = src[x].red;
+        rgb[1] = src[x].green;
+        rgb[2] = src[x].blue;
+        if (hdr) {
+         if ( m_labDomain )    {
+             double cur = LUMINANCE(fromHDR(rgb[0]),
+                                    fromHDR(rgb[1]),
+                                    fromHDR(rgb[1]));
+             double lum = fromHDR(m_hdrLut[clamp(toHDR(cur))]);
+             double mul = log2(lum/cur)*4096;
+             rgb[0] = mul + rgb[0];
+             rgb[1] = mul + rgb[1];
+             rgb[2] = mul + rgb[2];
+         }
+         else {
+             rgb[0] = m_hdrLut[rgb[0]];
+             rgb[1] = m_hdrLut[rgb[1]];
+             rgb[2] = m_hdrLut[rgb[2]];
+         }
         }
-        for (int x = 0 ; x < w ; ++x ) {
-            quantum_t rgb[3];
-            rgb[0] = src[x].red;
-            rgb[1] = src[x].green;
-            rgb[2] = src[x].blue;
-            if (hdr) {
-             if ( m_labDomain )    {
-                 double cur = LUMINANCE(fromHDR(rgb[0]),
-                                        fromHDR(rgb[1]),
-                                        fromHDR(rgb[1]));
-                 double lum = fromHDR(m_hdrLut[clamp(toHDR(cur))]);
-                 double mul = log2(lum/cur)*4096;
-                 rgb[0] = mul + rgb[0];
-                 rgb[1] = mul + rgb[1];
-                 rgb[2] = mul + rgb[2];
-             }
-             else {
-                 rgb[0] = m_hdrLut[rgb[0]];
-                 rgb[1] = m_hdrLut[rgb[1]];
-                 rgb[2] = m_hdrLut[rgb[2]];
-             }
+        else {
+            if ( m_labDomain ) {
+                double cur = LUMINANCE(rgb[0],
+                                       rgb[1],
+                                       rgb[2]);
+                double lum = m_lut[clamp<quantum_t>(DF_ROUND(cur))];
+                double mul = lum/cur;
+                rgb[0] = mul*rgb[0];
+                rgb[1] = mul*rgb[1];
+                rgb[2] = mul*rgb[2];
             }
             else {
-                if ( m_labDomain ) {
-                    double cur = LUMINANCE(rgb[0],
-                                           rgb[1],
-                                           rgb[2]);
-                    double lum = m_lut[clamp<quantum_t>(DF_ROUND(cur))];
-                    double mul = lum/cur;
-                    rgb[0] = mul*rgb[0];
-                    rgb[1] = mul*rgb[1];
-                    rgb[2] = mul*rgb[2];
-                }
-                else {
-                    rgb[0] = m_lut[rgb[0]];
-                    rgb[1] = m_lut[rgb[1]];
-                    rgb[2] = m_lut[rgb[2]];
-                }
+                rgb[0] = m_lut[rgb[0]];
+                rgb[1] = m_lut[rgb[1]];
+                rgb[2] = m_lut[rgb[2]];
             }
-            pixels[x].red = clamp(rgb[0]);
-            pixels[x].green = clamp(rgb[1]);
-            pixels[x].blue = clamp(rgb[2]);
-
         }
-        pixel_cache->sync();
-    });
+        dst[x].red = clamp(rgb[0]);
+        dst[x].green = clamp(rgb[1]);
+        dst[x].blue = clamp(rgb[2]);
+
+    }
+}
+
+std::shared_ptr<const quantum_t> ShapeDynamicRange::channelLut(bool hdr) const
+{
+    /* in the Lab domain channels are not independent */
+    if ( m_labDomain )
+        return std::shared_ptr<const quantum_t>();
+    return LutBased::channelLut(hdr);
 }
@@ -45,7 +45,10 @@ public:
                       qreal exposure,
                       bool labDomain,
                       QObject *parent = 0);
-    void applyOnImage(Magick::Image& image, bool hdr);
+    void applyOnPixels(const Magick::PixelPacket *src,
+                       Magick::PixelPacket *dst,
+                       int count, bool hdr);
+    std::shared_ptr<const quantum_t> channelLut(bool hdr) const;
 private:
     Shape m_shape;
     qreal m_dynamicRange;
@@ -33,7 +33,7 @@
 
 using Magick::Quantum;
 
-Threshold::Threshold(qreal high, qreal low, QObject *parent) :
+Threshold::Threshold(qreal high, qreal low, bool invert, QObject *parent) :
     LutBased(parent)
 {
     quantum_t h = high * QuantumRange;
@@ -41,9 +41,12 @@ Threshold::Threshold(qreal high, qreal low, QObject *parent) :
 
     quantum_t up = QuantumRange;
     quantum_t down = 0;
-    if ( low > high ) {
+    if ( invert ) {
         down = QuantumRange;
         up = 0;
+    }
+    if ( low > high ) {
+        qSwap(up, down);
         quantum_t tmp = h;
         h = l;
         l = tmp;
@@ -37,7 +37,12 @@ class Threshold : public LutBased
 {
     Q_OBJECT
 public:
-    explicit Threshold(qreal high, qreal low, QObject *parent = 0);
+    /**
+     * @brief Threshold
+     * @param invert the values between low and high go to 0, the other
+     * ones to QuantumRange
+     */
+    explicit Threshold(qreal high, qreal low, bool invert = false, QObject *parent = 0);
 };
 
 #endif // THRESHOLD_H
@@ -42,7 +42,10 @@ public:
                           bool safe,
                           QObject *parent = 0);
 
-    void applyOnImage(Magick::Image& image, bool hdr);
+    bool isPointWise() const;
+    void applyOnPixels(const Magick::PixelPacket *src,
+                       Magick::PixelPacket *dst,
+                       int count, bool hdr);
 
     static void Temperature_to_RGB(qreal T, qreal RGB[3]);
 signals:
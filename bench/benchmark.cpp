@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QCoreApplication>
+#include <cstdio>
+
+#include "benchmark.h"
+#include "process.h"
+#include "operator.h"
+#include "operatoroutput.h"
+#include "algorithm.h"
+#include "igamma.h"
+#include "preferences.h"
+#include "console.h"
+
+/*
+ * holds the frames of one input of the benchmarked operator, it is up
+ * to date from the start and never played. Not cacheable, so that the
+ * result cache never answers for the operator
+ */
+class FrameSource : public Operator
+{
+public:
+    FrameSource(const QVector<Photo>& frames, Process *parent) :
+        Operator(OP_SECTION_ASSETS, QT_TRANSLATE_NOOP("Operator", "Frames"), Operator::All, parent)
+    {
+        addOutput(new OperatorOutput(tr("Frames"), this));
+        getOutputs()[0]->setResult(frames);
+        setUpToDate();
+    }
+    Operator *newInstance() { return NULL; }
+    OperatorWorker *newWorker() { return NULL; }
+    bool isCacheable() const { return false; }
+};
+
+Benchmark::Benchmark(const QRegExp &filter, int repeat, QObject *parent) :
+    QObject(parent),
+    m_filter(filter),
+    m_repeat(qMax(1, repeat)),
+    m_process(new Process(NULL, this)),
+    m_results()
+{
+}
+
+bool Benchmark::selected(const QString &name) const
+{
+    return m_filter.isEmpty() || m_filter.indexIn(name) >= 0;
+}
+
+void Benchmark::runAlgorithm(const QString &name, Algorithm *algorithm, const Photo &frame)
+{
+    bool hdr = frame.getScale() == Photo::HDR;
+    QString fullName = name + (hdr ? "/hdr" : "/linear");
+    if ( !selected(fullName) )
+        return;
+    QVector<qint64> times;
+    for (int i = 0 ; i < m_repeat ; ++i ) {
+        Magick::Image image(frame.image());
+        image.modifyImage();
+        QElapsedTimer timer;
+        timer.start();
+        algorithm->applyOnImage(image, hdr);
+        times.push_back(timer.nsecsElapsed() / 1000);
+    }
+    record("algorithm", fullName, frame, 1, times, true);
+}
+
+/**
+ * @brief Benchmark::play plays op once its sources are connected
+ * @return true if the operator succeeded
+ */
+bool Benchmark::play(Operator *op)
+{
+    QEventLoop loop;
+    connect(op, SIGNAL(upToDate()), &loop, SLOT(quit()));
+    connect(op, SIGNAL(failed()), &loop, SLOT(quit()));
+    op->play();
+    /* the worker reports through queued signals, they can't be missed */
+    if ( !op->isUpToDate() )
+        loop.exec();
+    return op->isUpToDate();
+}
+
+void Benchmark::runOperator(const QString &name, Operator *op,
+                            const QVector<QVector<Photo> > &inputs)
+{
+    if ( !selected(name) || inputs.isEmpty() || inputs[0].isEmpty() )
+        return;
+    /* operators can't be deleted once connected, they are kept with
+     * the process, only the photos are released */
+    QVector<Operator*> sources;
+    for (int i = 0 ; i < inputs.count() ; ++i ) {
+        sources.push_back(new FrameSource(inputs[i], m_process));
+        Operator::operator_connect(sources[i], 0, op, i);
+    }
+    QVector<qint64> times;
+    bool success = true;
+    for (int i = 0 ; success && i < m_repeat ; ++i ) {
+        op->dropPhotoMemo();
+        op->setOutOfDate();
+        QElapsedTimer timer;
+        timer.start();
+        success = play(op);
+        times.push_back(timer.nsecsElapsed() / 1000);
+    }
+    op->setOutOfDate();
+    op->dropPhotoMemo();
+    foreach(Operator *source, sources)
+        source->getOutputs()[0]->clearResult();
+    record("operator", name, inputs[0][0], inputs[0].count(), times, success);
+}
+
+void Benchmark::runPixmaps(const Photo &frame)
+{
+    QVector<qint64> imageTimes;
+    QVector<qint64> histogramTimes;
+    for (int i = 0 ; i < m_repeat ; ++i ) {
+        Photo photo(frame);
+        QElapsedTimer timer;
+        if ( selected("imageToPixmap") ) {
+            timer.start();
+            photo.imageToPixmap(SRGB_G, SRGB_N, 1.);
+            imageTimes.push_back(timer.nsecsElapsed() / 1000);
+        }
+        if ( selected("histogramToPixmap") ) {
+            timer.start();
+            photo.histogramToPixmap(Photo::HistogramLogarithmic, Photo::HistogramLines);
+            histogramTimes.push_back(timer.nsecsElapsed() / 1000);
+        }
+    }
+    if ( !imageTimes.isEmpty() )
+        record("view", "imageToPixmap", frame, 1, imageTimes, true);
+    if ( !histogramTimes.isEmpty() )
+        record("view", "histogramToPixmap", frame, 1, histogramTimes, true);
+}
+
+void Benchmark::record(const char *group, const QString &name,
+                       const Photo &frame, int frames,
+                       const QVector<qint64> &times, bool success)
+{
+    Result result;
+    result.group = group;
+    result.name = name;
+    result.columns = frame.image().columns();
+    result.rows = frame.image().rows();
+    result.frames = frames;
+    result.best = times.isEmpty() ? 0 : times[0];
+    qint64 total = 0;
+    foreach(qint64 t, times) {
+        result.best = qMin(result.best, t);
+        total += t;
+    }
+    result.mean = times.isEmpty() ? 0 : total / times.count();
+    result.success = success;
+    m_results.push_back(result);
+    dflInfo(tr("%0 %1x%2: %3ms%4")
+            .arg(name).arg(result.columns).arg(result.rows)
+            .arg(result.best / 1000.)
+            .arg(success ? "" : " FAILED"));
+}
+
+void Benchmark::print() const
+{
+    fprintf(stdout, "%-40s %6s %6s %10s %10s %9s\n",
+            "benchmark", "MP", "frames", "best (ms)", "mean (ms)", "MP/s");
+    foreach(const Result& r, m_results) {
+        double mp = double(r.columns) * r.rows / 1000000.;
+        fprintf(stdout, "%-40s %6.1f %6d %10.1f %10.1f %9.1f%s\n",
+                r.name.toLocal8Bit().constData(),
+                mp, r.frames,
+                r.best / 1000., r.mean / 1000.,
+                r.best ? mp * r.frames * 1000000. / r.best : 0.,
+                r.success ? "" : " FAILED");
+    }
+    fflush(stdout);
+}
+
+bool Benchmark::write(const QString &filename) const
+{
+    QJsonArray results;
+    foreach(const Result& r, m_results) {
+        QJsonObject obj;
+        double mp = double(r.columns) * r.rows / 1000000.;
+        obj["group"] = r.group;
+        obj["name"] = r.name;
+        obj["columns"] = r.columns;
+        obj["rows"] = r.rows;
+        obj["megapixels"] = mp;
+        obj["frames"] = r.frames;
+        obj["bestMicroseconds"] = double(r.best);
+        obj["meanMicroseconds"] = double(r.mean);
+        obj["megapixelsPerSecond"] = r.best ? mp * r.frames * 1000000. / r.best : 0.;
+        obj["success"] = r.success;
+        results.push_back(obj);
+    }
+    QJsonObject root;
+    root["application"] = QCoreApplication::applicationName();
+    root["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    root["architecture"] = QString(DF_ARCH);
+    root["threads"] = preferences->getNumThreads();
+    root["quantumDepth"] = int(MAGICKCORE_QUANTUM_DEPTH);
+    root["repeat"] = m_repeat;
+    root["results"] = results;
+    QFile file(filename);
+    if ( !file.open(QIODevice::WriteOnly|QIODevice::Truncate) )
+        return false;
+    QByteArray data = QJsonDocument(root).toJson();
+    return file.write(data) == data.size();
+}
+
+int Benchmark::failures() const
+{
+    int n = 0;
+    foreach(const Result& r, m_results)
+        if ( !r.success )
+            ++n;
+    return n;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QObject>
+#include <QVector>
+#include <QString>
+#include <QRegExp>
+
+#include "photo.h"
+
+class Process;
+class Operator;
+class Algorithm;
+
+/**
+ * @brief The Benchmark class times algorithms, workers and views on
+ * synthetic frames and keeps the results for a report
+ */
+class Benchmark : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Benchmark
+     * @param filter only the benchmarks whose name matches are run
+     * @param repeat runs of each benchmark, the best one is reported
+     */
+    Benchmark(const QRegExp& filter, int repeat, QObject *parent = 0);
+
+    bool selected(const QString& name) const;
+
+    void runAlgorithm(const QString& name, Algorithm *algorithm, const Photo& frame);
+    /**
+     * @brief runOperator plays op on inputs, one set of photos per input
+     * of the operator
+     */
+    void runOperator(const QString& name, Operator *op,
+                     const QVector<QVector<Photo> >& inputs);
+    void runPixmaps(const Photo& frame);
+
+    void print() const;
+    bool write(const QString& filename) const;
+    int failures() const;
+
+private:
+    typedef struct {
+        QString group;
+        QString name;
+        int columns;
+        int rows;
+        int frames;
+        qint64 best;
+        qint64 mean;
+        bool success;
+    } Result;
+
+    void record(const char *group, const QString& name,
+                const Photo& frame, int frames,
+                const QVector<qint64>& times, bool success);
+    bool play(Operator *op);
+
+    QRegExp m_filter;
+    int m_repeat;
+    Process *m_process;
+    QVector<Result> m_results;
+};
+
+#endif // BENCHMARK_H
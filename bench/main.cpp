@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QStringList>
+#include <cstdio>
+
+#include "preferences.h"
+#include "console.h"
+#include "benchmark.h"
+#include "syntheticframes.h"
+#include "channelmixer.h"
+#include "colorfilter.h"
+#include "desaturateshadows.h"
+#include "exposure.h"
+#include "hdr.h"
+#include "hotpixels.h"
+#include "igamma.h"
+#include "invert.h"
+#include "selectivelabfilter.h"
+#include "shapedynamicrange.h"
+#include "threshold.h"
+#include "whitebalance.h"
+#include "opintegration.h"
+#include "opdebayer.h"
+#include "opssdreg.h"
+#include "opphasecorrelationreg.h"
+#include "opconvolution.h"
+
+static const char *RejectionNames[] = {
+    "None", "MinMax", "AverageDeviation", "SigmaClipping",
+    "Median", "WinsorizedSigmaClipping", "LinearFitClipping"
+};
+
+static const struct {
+    OpDebayer::Debayer quality;
+    const char *name;
+} DebayerQualities[] = {
+    { OpDebayer::NoDebayer, "None" },
+    { OpDebayer::Mask, "Mask" },
+    { OpDebayer::HalfSize, "HalfSize" },
+    { OpDebayer::Simple, "Simple" },
+    { OpDebayer::Bilinear, "Bilinear" },
+    { OpDebayer::HQLinear, "HQLinear" },
+    { OpDebayer::VNG, "VNG" },
+    { OpDebayer::AHD, "AHD" },
+};
+
+static void benchAlgorithms(Benchmark& bench, const Photo& linear, const Photo& hdr)
+{
+    struct {
+        const char *name;
+        Algorithm *algorithm;
+    } algorithms[] = {
+        { "ChannelMixer", new ChannelMixer() },
+        { "ColorFilter", new ColorFilter(1., .9, .8) },
+        { "DesaturateShadows", new DesaturateShadows(1./(1<<5), 1<<3, 0) },
+        { "Exposure", new Exposure(2.) },
+        { "HDR", new HDR(false) },
+        { "HDR/revert", new HDR(true) },
+        { "HotPixels", new HotPixels(M_SQRT2l, false, false) },
+        { "HotPixels/aggressive", new HotPixels(M_SQRT2l, true, false) },
+        { "iGamma/sRGB", new iGamma(SRGB_G, SRGB_N) },
+        { "Invert", new Invert() },
+        { "SelectiveLabFilter", new SelectiveLabFilter(60, 30, .5, true, 1., true, false) },
+        { "ShapeDynamicRange", new ShapeDynamicRange(ShapeDynamicRange::TanH, 1<<10, 1, false) },
+        { "ShapeDynamicRange/lab", new ShapeDynamicRange(ShapeDynamicRange::TanH, 1<<10, 1, true) },
+        { "Threshold", new Threshold(.5, .1) },
+        { "WhiteBalance", new WhiteBalance(5000, 1, true) },
+    };
+    for (size_t i = 0 ; i < sizeof(algorithms)/sizeof(*algorithms) ; ++i ) {
+        bench.runAlgorithm(algorithms[i].name, algorithms[i].algorithm, linear);
+        bench.runAlgorithm(algorithms[i].name, algorithms[i].algorithm, hdr);
+        delete algorithms[i].algorithm;
+    }
+}
+
+static void benchWorkers(Benchmark& bench, Process *process,
+                         const QVector<Photo>& frames, const Photo& cfa)
+{
+    QVector<QVector<Photo> > stack(1, frames);
+    for (int r = OpIntegration::NoRejection ; r <= OpIntegration::LinearFitClipping ; ++r ) {
+        OpIntegration *op = new OpIntegration(process);
+        op->setRejectionType(r);
+        bench.runOperator(QString("Integration/%0").arg(RejectionNames[r]), op, stack);
+    }
+    OpIntegration *drizzle = new OpIntegration(process);
+    drizzle->setDrizzle(true);
+    bench.runOperator("Integration/Drizzle", drizzle, stack);
+
+    QVector<QVector<Photo> > mosaic(1, QVector<Photo>(1, cfa));
+    for (size_t i = 0 ; i < sizeof(DebayerQualities)/sizeof(*DebayerQualities) ; ++i ) {
+        OpDebayer *op = new OpDebayer(process);
+        op->setDebayer(DebayerQualities[i].quality);
+        bench.runOperator(QString("Debayer/%0").arg(DebayerQualities[i].name), op, mosaic);
+    }
+
+    /* a pair is enough, the reference is looked for everywhere in the other */
+    QVector<Photo> pair = frames.mid(0, 2);
+    if ( pair.count() == 2 ) {
+        const Magick::Image& image = pair[0].image();
+        pair[0].setTag(TAG_TREAT, TAG_TREAT_REFERENCE);
+        pair[0].setROI(QRectF(image.columns()/2, image.rows()/2, 16, 16));
+        bench.runOperator("SsdReg", new OpSsdReg(process), QVector<QVector<Photo> >(1, pair));
+        bench.runOperator("PhaseCorrelationReg", new OpPhaseCorrelationReg(process),
+                          QVector<QVector<Photo> >(1, pair));
+    }
+
+    QVector<QVector<Photo> > convolution;
+    convolution.push_back(QVector<Photo>(1, frames[0]));
+    convolution.push_back(QVector<Photo>(1, SyntheticFrames::star(31, 3.)));
+    bench.runOperator("Convolution/FFT", new OpConvolution(process), convolution);
+}
+
+/*
+ * darkflow-bench [-s 12,24,36,60] [-n frames] [-r repeat] [-f regexp] [-o results.json]
+ *
+ * Times the algorithms, the main workers and the views on synthetic
+ * frames of each size and writes the results as JSON, so that two
+ * releases can be compared. Exits with 1 if a worker failed
+ */
+int main(int argc, char *argv[])
+{
+    if ( qgetenv("QT_QPA_PLATFORM").isEmpty() )
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication a(argc, argv);
+    QApplication::setApplicationName("darkflow");
+    init_platform();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QApplication::tr("Time DarkFlow algorithms and workers on synthetic frames"));
+    parser.addHelpOption();
+    QCommandLineOption sizesOption(QStringList() << "s" << "sizes",
+                                   QApplication::tr("Comma separated frame sizes in megapixels"),
+                                   QApplication::tr("sizes"), "12,24,36,60");
+    QCommandLineOption framesOption(QStringList() << "n" << "frames",
+                                    QApplication::tr("Frames to integrate"),
+                                    QApplication::tr("frames"), "8");
+    QCommandLineOption repeatOption(QStringList() << "r" << "repeat",
+                                    QApplication::tr("Runs of each benchmark, the best is reported"),
+                                    QApplication::tr("repeat"), "3");
+    QCommandLineOption filterOption(QStringList() << "f" << "filter",
+                                    QApplication::tr("Only run the benchmarks whose name matches"),
+                                    QApplication::tr("regexp"));
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                    QApplication::tr("Results file"),
+                                    QApplication::tr("file"), "darkflow-bench.json");
+    parser.addOption(sizesOption);
+    parser.addOption(framesOption);
+    parser.addOption(repeatOption);
+    parser.addOption(filterOption);
+    parser.addOption(outputOption);
+    parser.process(a);
+
+    QVector<int> sizes;
+    foreach(const QString& size, parser.value(sizesOption).split(',', QString::SkipEmptyParts)) {
+        bool ok;
+        int mp = size.toInt(&ok);
+        if ( !ok || mp <= 0 ) {
+            fprintf(stderr, "%s", parser.helpText().toLocal8Bit().constData());
+            return 2;
+        }
+        sizes.push_back(mp);
+    }
+    int nFrames = qMax(2, parser.value(framesOption).toInt());
+
+    Console::init(true);
+    preferences = new Preferences();
+    Console::setRaiseLevel(Console::LastLevel);
+
+    Benchmark bench(QRegExp(parser.value(filterOption)), parser.value(repeatOption).toInt());
+    Process *process = new Process(NULL);
+    foreach(int mp, sizes) {
+        QSize size = SyntheticFrames::geometry(mp);
+        dflInfo(QApplication::tr("%0 MP frames (%1x%2)").arg(mp).arg(size.width()).arg(size.height()));
+        QVector<Photo> frames;
+        for (int i = 0 ; i < nFrames ; ++i )
+            frames.push_back(SyntheticFrames::starField(size, i + 1));
+        Photo hdr = SyntheticFrames::hdr(frames[0]);
+        Photo cfa = SyntheticFrames::mosaic(frames[0]);
+
+        benchAlgorithms(bench, frames[0], hdr);
+        benchWorkers(bench, process, frames, cfa);
+        bench.runPixmaps(frames[0]);
+        /* flush queued log messages */
+        Console::flush();
+    }
+
+    bench.print();
+    QString output = parser.value(outputOption);
+    if ( !bench.write(output) ) {
+        fprintf(stderr, "%s\n", QApplication::tr("Failed to write %0").arg(output).toLocal8Bit().constData());
+        return 2;
+    }
+    return bench.failures() ? 1 : 0;
+}
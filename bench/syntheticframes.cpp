@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#include <QVector>
+#include <Magick++.h>
+#include <cmath>
+#include <random>
+
+#include "syntheticframes.h"
+#include "algorithm.h"
+#include "hdr.h"
+
+using Magick::Quantum;
+
+#define SKY_LEVEL (QuantumRange/64.)
+#define READ_NOISE (QuantumRange/512.)
+#define STAR_DENSITY 20000 /* pixels per star */
+
+struct Star {
+    double x, y;
+    double sigma;
+    double red, green, blue;
+};
+
+QSize SyntheticFrames::geometry(int megapixels)
+{
+    int h = int(sqrt(megapixels * 1000000. / 1.5));
+    int w = int(h * 1.5);
+    return QSize(w & ~1, h & ~1);
+}
+
+Photo SyntheticFrames::starField(const QSize &size, quint32 seed)
+{
+    int w = size.width();
+    int h = size.height();
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    QVector<Star> stars(qMax(1, w * h / STAR_DENSITY));
+    for (int i = 0 ; i < stars.count() ; ++i ) {
+        Star& star = stars[i];
+        double amplitude = QuantumRange * (.05 + .85 * pow(uniform(rng), 4));
+        star.x = uniform(rng) * w;
+        star.y = uniform(rng) * h;
+        star.sigma = 1. + 1.5 * uniform(rng);
+        star.red = amplitude * (.8 + .4 * uniform(rng));
+        star.green = amplitude;
+        star.blue = amplitude * (.8 + .4 * uniform(rng));
+    }
+
+    Photo photo(Photo::Linear);
+    photo.createImage(w, h);
+    Magick::Image& image = photo.image();
+    image.modifyImage();
+    std::shared_ptr<FramePixels> pixels(new FramePixels(image, true));
+    dfl_parallel_for(y, 0, h, 4, (), {
+        Magick::PixelPacket *row = pixels->get(y, 1);
+        std::mt19937 rowRng(seed * 2654435761u + y);
+        std::normal_distribution<double> noise(0, READ_NOISE);
+        QVector<double> red(w, SKY_LEVEL), green(w, SKY_LEVEL), blue(w, SKY_LEVEL);
+        foreach(const Star& star, stars) {
+            double dy = y - star.y;
+            double reach = 4 * star.sigma;
+            if ( fabs(dy) > reach )
+                continue;
+            int x0 = qMax(0, int(star.x - reach));
+            int x1 = qMin(w - 1, int(star.x + reach));
+            for (int x = x0 ; x <= x1 ; ++x ) {
+                double dx = x - star.x;
+                double g = exp(-(dx*dx + dy*dy) / (2 * star.sigma * star.sigma));
+                red[x] += g * star.red;
+                green[x] += g * star.green;
+                blue[x] += g * star.blue;
+            }
+        }
+        for (int x = 0 ; x < w ; ++x ) {
+            row[x].red = clamp<quantum_t>(DF_ROUND(red[x] + noise(rowRng)));
+            row[x].green = clamp<quantum_t>(DF_ROUND(green[x] + noise(rowRng)));
+            row[x].blue = clamp<quantum_t>(DF_ROUND(blue[x] + noise(rowRng)));
+        }
+        pixels->sync();
+    });
+    pixels.reset();
+    QString name = QString("synthetic-%0x%1-%2").arg(w).arg(h).arg(seed);
+    photo.setIdentity(name);
+    photo.setTag(TAG_NAME, name);
+    return photo;
+}
+
+Photo SyntheticFrames::mosaic(const Photo &rgb)
+{
+    Photo photo(rgb);
+    Magick::Image& image = photo.image();
+    image.modifyImage();
+    int w = image.columns();
+    int h = image.rows();
+    std::shared_ptr<FramePixels> pixels(new FramePixels(image, true));
+    dfl_parallel_for(y, 0, h, 4, (), {
+        Magick::PixelPacket *row = pixels->get(y, 1);
+        for (int x = 0 ; x < w ; ++x ) {
+            quantum_t v;
+            if ( (y & 1) == 0 )
+                v = (x & 1) == 0 ? row[x].red : row[x].green;
+            else
+                v = (x & 1) == 0 ? row[x].green : row[x].blue;
+            row[x].red = row[x].green = row[x].blue = v;
+        }
+        pixels->sync();
+    });
+    pixels.reset();
+    photo.setIdentity(rgb.getIdentity() + "-cfa");
+    photo.setTag(TAG_NAME, rgb.getIdentity() + "-cfa");
+    photo.setTag(TAG_FILTER_PATTERN, "RG/GB");
+    return photo;
+}
+
+Photo SyntheticFrames::hdr(const Photo &linear)
+{
+    Photo photo(linear);
+    HDR(false).applyOn(photo);
+    photo.setIdentity(linear.getIdentity() + "-hdr");
+    photo.setTag(TAG_NAME, linear.getIdentity() + "-hdr");
+    return photo;
+}
+
+Photo SyntheticFrames::star(int size, double sigma)
+{
+    Photo photo(Photo::Linear);
+    photo.createImage(size, size);
+    Magick::Image& image = photo.image();
+    image.modifyImage();
+    FramePixels pixels(image, true);
+    double c = (size - 1) / 2.;
+    for (int y = 0 ; y < size ; ++y ) {
+        Magick::PixelPacket *row = pixels.get(y, 1);
+        for (int x = 0 ; x < size ; ++x ) {
+            double d2 = (x - c) * (x - c) + (y - c) * (y - c);
+            quantum_t v = clamp<quantum_t>(DF_ROUND(QuantumRange * exp(-d2 / (2 * sigma * sigma))));
+            row[x].red = row[x].green = row[x].blue = v;
+        }
+        pixels.sync();
+    }
+    photo.setIdentity(QString("synthetic-star-%0").arg(size));
+    photo.setTag(TAG_NAME, photo.getIdentity());
+    return photo;
+}
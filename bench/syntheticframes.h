@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#ifndef SYNTHETICFRAMES_H
+#define SYNTHETICFRAMES_H
+
+#include <QSize>
+#include "photo.h"
+
+/**
+ * @brief The SyntheticFrames class makes reproducible frames for the
+ * benchmarks, a given seed always gives the same pixels
+ */
+class SyntheticFrames
+{
+public:
+    /**
+     * @brief geometry
+     * @return a 3:2 frame of about megapixels, with even sides
+     */
+    static QSize geometry(int megapixels);
+    /**
+     * @brief starField sky background with read noise and gaussian stars
+     */
+    static Photo starField(const QSize& size, quint32 seed);
+    /**
+     * @brief mosaic samples rgb through an RGGB color filter array, the
+     * photo is tagged for the Debayer operator
+     */
+    static Photo mosaic(const Photo& rgb);
+    /**
+     * @brief hdr the same pixels, HDR encoded
+     */
+    static Photo hdr(const Photo& linear);
+    /**
+     * @brief star a single gaussian star, to be used as a kernel
+     */
+    static Photo star(int size, double sigma);
+};
+
+#endif // SYNTHETICFRAMES_H
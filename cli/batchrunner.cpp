@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#include <cstdio>
+
+#include "batchrunner.h"
+#include "process.h"
+#include "operator.h"
+#include "operatorinput.h"
+#include "operatoroutput.h"
+#include "console.h"
+
+BatchRunner::BatchRunner(Process *process, const QStringList &targets, QObject *parent) :
+    QObject(parent),
+    m_process(process),
+    m_targetNames(targets),
+    m_targets(),
+    m_status(),
+    m_elapsed(),
+    m_timer(),
+    m_pending(0)
+{
+}
+
+bool BatchRunner::resolveTargets()
+{
+    QVector<Operator*> operators = m_process->operators();
+    m_targets.clear();
+    if ( m_targetNames.isEmpty() ) {
+        foreach(Operator *op, operators) {
+            if ( op->getClassIdentifier() == "Save" && op->isEnabled() )
+                m_targets.push_back(op);
+        }
+    }
+    else {
+        foreach(const QString& name, m_targetNames) {
+            bool found = false;
+            foreach(Operator *op, operators) {
+                if ( op->getName() == name || op->uuid() == name ) {
+                    if ( !m_targets.contains(op) )
+                        m_targets.push_back(op);
+                    found = true;
+                }
+            }
+            if ( !found ) {
+                dflError(tr("No operator named %0").arg(name));
+                return false;
+            }
+        }
+    }
+    if ( m_targets.isEmpty() ) {
+        dflError(tr("Nothing to play"));
+        return false;
+    }
+    return true;
+}
+
+QVector<Operator *> BatchRunner::targets() const
+{
+    return m_targets;
+}
+
+bool BatchRunner::start()
+{
+    if ( m_targets.isEmpty() && !resolveTargets() )
+        return false;
+    QVector<Operator*> operators = m_process->operators();
+    foreach(Operator *op, operators) {
+        connect(op, SIGNAL(failed()), this, SLOT(operatorFailed()));
+    }
+    foreach(Operator *op, m_targets) {
+        m_status[op] = Pending;
+        connect(op, SIGNAL(upToDate()), this, SLOT(operatorUpToDate()));
+    }
+    m_pending = m_targets.count();
+    m_timer.start();
+    foreach(Operator *op, m_targets) {
+        /* results installed by a frame farm */
+        if ( op->isUpToDate() ) {
+            setStatus(op, Done);
+            continue;
+        }
+        dflInfo(tr("Playing %0").arg(op->getName()));
+        op->play();
+    }
+    return true;
+}
+
+int BatchRunner::exitCode() const
+{
+    foreach(Operator *op, m_targets) {
+        if ( m_status[op] != Done )
+            return 1;
+    }
+    return 0;
+}
+
+void BatchRunner::printSummary() const
+{
+    fprintf(stdout, "%-32s %-8s %10s %8s\n", "operator", "status", "time (ms)", "photos");
+    foreach(Operator *op, m_targets) {
+        int photos = 0;
+        foreach(OperatorOutput *output, op->getOutputs())
+            photos += output->resultCount();
+        const char *status = m_status[op] == Done ? "done" :
+                             m_status[op] == Failed ? "FAILED" : "pending";
+        fprintf(stdout, "%-32s %-8s %10lld %8d\n",
+                op->getName().toLocal8Bit().constData(),
+                status,
+                static_cast<long long>(m_elapsed.value(op, m_timer.elapsed())),
+                photos);
+    }
+    fprintf(stdout, "total: %lld ms\n", static_cast<long long>(m_timer.elapsed()));
+    fflush(stdout);
+}
+
+void BatchRunner::operatorUpToDate()
+{
+    Operator *op = qobject_cast<Operator*>(sender());
+    if ( op && m_status.value(op, Done) == Pending )
+        setStatus(op, Done);
+}
+
+void BatchRunner::operatorFailed()
+{
+    Operator *failed = qobject_cast<Operator*>(sender());
+    if ( !failed )
+        return;
+    dflError(tr("%0 failed").arg(failed->getName()));
+    foreach(Operator *op, m_targets) {
+        if ( m_status[op] == Pending && dependsOn(op, failed) )
+            setStatus(op, Failed);
+    }
+}
+
+bool BatchRunner::dependsOn(Operator *op, Operator *ancestor)
+{
+    if ( op == ancestor )
+        return true;
+    foreach(OperatorInput *input, op->getInputs()) {
+        foreach(OperatorOutput *source, input->sources()) {
+            if ( dependsOn(source->m_operator, ancestor) )
+                return true;
+        }
+    }
+    return false;
+}
+
+void BatchRunner::setStatus(Operator *op, BatchRunner::TargetStatus status)
+{
+    m_status[op] = status;
+    m_elapsed[op] = m_timer.elapsed();
+    if ( --m_pending == 0 )
+        emit finished(exitCode());
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <QObject>
+#include <QVector>
+#include <QMap>
+#include <QElapsedTimer>
+#include <QStringList>
+
+class Process;
+class Operator;
+
+/**
+ * @brief The BatchRunner class plays a set of target operators of a
+ * headless process and reports when all of them are either up to date
+ * or failed
+ */
+class BatchRunner : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief BatchRunner
+     * @param process a headless process, already loaded
+     * @param targets names or uuids of the operators to play,
+     * all the Save operators when empty
+     */
+    BatchRunner(Process *process, const QStringList& targets, QObject *parent = 0);
+
+    /**
+     * @brief resolveTargets finds the target operators, start() does it
+     * when it has not been done before
+     * @return false if no target could be found
+     */
+    bool resolveTargets();
+    QVector<Operator*> targets() const;
+
+    /**
+     * @brief start
+     * @return false if no target could be found
+     */
+    bool start();
+
+    int exitCode() const;
+    void printSummary() const;
+
+    static bool dependsOn(Operator *op, Operator *ancestor);
+
+signals:
+    void finished(int exitCode);
+
+private slots:
+    void operatorUpToDate();
+    void operatorFailed();
+
+private:
+    typedef enum {
+        Pending,
+        Done,
+        Failed
+    } TargetStatus;
+
+    Process *m_process;
+    QStringList m_targetNames;
+    QVector<Operator*> m_targets;
+    QMap<Operator*, TargetStatus> m_status;
+    QMap<Operator*, qint64> m_elapsed;
+    QElapsedTimer m_timer;
+    int m_pending;
+
+    void setStatus(Operator *op, TargetStatus status);
+};
+
+#endif // BATCHRUNNER_H
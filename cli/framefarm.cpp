@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QTemporaryDir>
+#include <algorithm>
+
+#include "ports.h"
+#if defined(DF_WINDOWS) || defined(ANDROID)
+# include <QProcess>
+# define PROCESSCLASS QProcess
+#else
+# include "posixspawn.h"
+# define PROCESSCLASS PosixSpawn
+#endif
+
+#include "framefarm.h"
+#include "batchrunner.h"
+#include "process.h"
+#include "operator.h"
+#include "operatorinput.h"
+#include "operatoroutput.h"
+#include "operatorparameterfilescollection.h"
+#include "resultcache.h"
+#include "threadbudget.h"
+#include "console.h"
+
+static bool sequenceLessThan(const Photo& a, const Photo& b)
+{
+    return a.getSequenceNumber() < b.getSequenceNumber();
+}
+
+FrameFarm::FrameFarm(Process *process, const QString &project, int processes, QObject *parent) :
+    QObject(parent),
+    m_process(process),
+    m_project(project),
+    m_processes(processes),
+    m_chains()
+{
+}
+
+int FrameFarm::plan(const QVector<Operator *> &targets)
+{
+    m_chains.clear();
+    foreach(Operator *op, m_process->operators()) {
+        OperatorParameterFilesCollection *files = filesCollection(op);
+        if ( !files || !op->isEnabled() || !op->getInputs().isEmpty() )
+            continue;
+        int frames = files->collection().count();
+        if ( frames < 2 )
+            continue;
+        Operator *target = op;
+        for ( Operator *sink = next(target) ; sink ; sink = next(target) )
+            target = sink;
+        /* loading alone is not worth the round trip */
+        if ( target == op )
+            continue;
+        bool needed = false;
+        foreach(Operator *t, targets)
+            needed = needed || BatchRunner::dependsOn(t, target);
+        if ( !needed )
+            continue;
+        Chain chain = { op, target, frames };
+        m_chains.push_back(chain);
+        dflInfo(tr("Farming %0 to %1, %2 frames").arg(op->getName()).arg(target->getName()).arg(frames));
+    }
+    return m_chains.count();
+}
+
+bool FrameFarm::run()
+{
+    bool success = true;
+    foreach(const Chain& chain, m_chains) {
+        if ( !runChain(chain) ) {
+            dflWarning(tr("Farm of %0 failed, played in this process").arg(chain.target->getName()));
+            success = false;
+        }
+    }
+    return success;
+}
+
+bool FrameFarm::runChain(const Chain &chain)
+{
+    QTemporaryDir dir;
+    if ( !dir.isValid() ) {
+        dflError(tr("Could not create a temporary directory"));
+        return false;
+    }
+    /* the master frames are played once, here, rather than by each child */
+    QVector<Operator*> inputs = chainInputs(chain);
+    if ( !playInputs(inputs) )
+        return false;
+    QStringList inputArgs;
+    foreach(Operator *op, inputs) {
+        QString filename = dir.path() + QString("/input-%0.dfr").arg(inputArgs.count()/2);
+        if ( !writeResults(m_process, op->uuid(), filename) )
+            return false;
+        inputArgs << "--shard-input" << QString("%0=%1").arg(op->uuid()).arg(filename);
+    }
+    int shards = qMin(m_processes, chain.frames);
+    /* the children share the cores of this process */
+    int threads = qMax(1, ThreadBudget::instance()->threads() / shards);
+    QStringList filenames;
+    QVector<PROCESSCLASS*> children;
+    for (int i = 0 ; i < shards ; ++i ) {
+        QString filename = dir.path() + QString("/shard-%0.dfr").arg(i);
+        QStringList args;
+        args << m_project
+             << "--operator" << chain.target->uuid()
+             << "--shard" << QString("%0/%1").arg(i).arg(shards)
+             << "--shard-source" << chain.source->uuid()
+             << "--shard-output" << filename
+             << "--threads" << QString::number(threads)
+             << inputArgs;
+        if ( Console::isEnabled(Console::Debug) )
+            args << "--verbose";
+        PROCESSCLASS *child = new PROCESSCLASS;
+#if defined(DF_WINDOWS) || defined(ANDROID)
+        child->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+#endif
+        /* stdout, the summary of the child, goes nowhere */
+        child->start(QCoreApplication::applicationFilePath(), args, QIODevice::WriteOnly);
+        children.push_back(child);
+        filenames.push_back(filename);
+    }
+    bool success = true;
+    foreach(PROCESSCLASS *child, children) {
+        if ( !child->waitForStarted() ||
+             !child->waitForFinished(-1) ||
+             child->exitCode() != 0 )
+            success = false;
+        delete child;
+    }
+    if ( !success )
+        return false;
+
+    int outputsCount = chain.target->getOutputs().count();
+    QVector<QVector<Photo> > merged(outputsCount);
+    for (int i = 0 ; i < shards ; ++i ) {
+        QVector<QVector<Photo> > outputs(outputsCount);
+        if ( !ResultCache::read(filenames[i], outputs) ) {
+            dflError(tr("Could not read the results of shard %0").arg(i));
+            return false;
+        }
+        /* the children numbered the frames of their shard from 0 */
+        int begin, end;
+        shardRange(chain.frames, i, shards, begin, end);
+        for (int o = 0 ; o < outputsCount ; ++o ) {
+            /* a frame lost in a child would shift the ones that follow,
+             * disabled outputs drop all of them */
+            if ( chain.target->getOutputStatus(o) == Operator::OutputEnabled &&
+                 outputs[o].count() != end - begin ) {
+                dflError(tr("Shard %0 gave %1 photos out of %2").arg(i).arg(outputs[o].count()).arg(end - begin));
+                return false;
+            }
+            foreach(Photo photo, outputs[o]) {
+                photo.setSequenceNumber(begin + photo.getSequenceNumber());
+                merged[o].push_back(photo);
+            }
+        }
+    }
+    int o = 0;
+    foreach(OperatorOutput *output, chain.target->getOutputs()) {
+        std::stable_sort(merged[o].begin(), merged[o].end(), sequenceLessThan);
+        output->setResult(merged[o]);
+        ++o;
+    }
+    chain.target->setUpToDate();
+    return true;
+}
+
+bool FrameFarm::shard(Process *process, const QString &source, int index, int count)
+{
+    Operator *op = findOperator(process, source);
+    OperatorParameterFilesCollection *files = op ? filesCollection(op) : NULL;
+    if ( !files || index < 0 || index >= count ) {
+        dflError(tr("Invalid shard %0/%1 of %2").arg(index).arg(count).arg(source));
+        return false;
+    }
+    QStringList collection = files->collection();
+    int begin, end;
+    shardRange(collection.count(), index, count, begin, end);
+    files->setCollection(collection.mid(begin, end - begin));
+    return true;
+}
+
+bool FrameFarm::writeResults(Process *process, const QString &target, const QString &filename)
+{
+    Operator *op = findOperator(process, target);
+    if ( !op )
+        return false;
+    QVector<QVector<Photo> > outputs;
+    foreach(OperatorOutput *output, op->getOutputs())
+        outputs.push_back(output->getResult());
+    if ( !ResultCache::write(filename, outputs) ) {
+        dflError(tr("Could not write %0").arg(filename));
+        return false;
+    }
+    return true;
+}
+
+bool FrameFarm::readResults(Process *process, const QString &target, const QString &filename)
+{
+    Operator *op = findOperator(process, target);
+    if ( !op )
+        return false;
+    QVector<QVector<Photo> > outputs(op->getOutputs().count());
+    if ( !ResultCache::read(filename, outputs) ) {
+        dflError(tr("Could not read %0").arg(filename));
+        return false;
+    }
+    int o = 0;
+    foreach(OperatorOutput *output, op->getOutputs())
+        output->setResult(outputs[o++]);
+    op->setUpToDate();
+    return true;
+}
+
+bool FrameFarm::playInputs(const QVector<Operator *> &inputs)
+{
+    QStringList uuids;
+    foreach(Operator *op, inputs)
+        uuids.push_back(op->uuid());
+    if ( uuids.isEmpty() )
+        return true;
+    BatchRunner runner(m_process, uuids);
+    QEventLoop loop;
+    connect(&runner, SIGNAL(finished(int)), &loop, SLOT(quit()), Qt::QueuedConnection);
+    if ( !runner.start() )
+        return false;
+    loop.exec();
+    return runner.exitCode() == 0;
+}
+
+/**
+ * @brief FrameFarm::chainInputs
+ * @return the operators feeding the chain other than through its first
+ * inputs, they do not depend on the source
+ */
+QVector<Operator *> FrameFarm::chainInputs(const FrameFarm::Chain &chain)
+{
+    QVector<Operator*> inputs;
+    Operator *op = chain.source;
+    while ( op != chain.target ) {
+        op = next(op);
+        QVector<OperatorInput*> opInputs = op->getInputs();
+        for (int i = 1 ; i < opInputs.count() ; ++i ) {
+            foreach(OperatorOutput *output, opInputs[i]->sources()) {
+                if ( !inputs.contains(output->m_operator) )
+                    inputs.push_back(output->m_operator);
+            }
+        }
+    }
+    return inputs;
+}
+
+Operator *FrameFarm::findOperator(Process *process, const QString &uuid)
+{
+    foreach(Operator *op, process->operators()) {
+        if ( op->uuid() == uuid )
+            return op;
+    }
+    return NULL;
+}
+
+/**
+ * @brief FrameFarm::filesCollection
+ * @return the collection of a source operator, if it has only one
+ */
+OperatorParameterFilesCollection *FrameFarm::filesCollection(Operator *op)
+{
+    OperatorParameterFilesCollection *files = NULL;
+    foreach(OperatorParameter *parameter, op->getParameters()) {
+        OperatorParameterFilesCollection *collection =
+                dynamic_cast<OperatorParameterFilesCollection*>(parameter);
+        if ( !collection )
+            continue;
+        if ( files )
+            return NULL;
+        files = collection;
+    }
+    return files;
+}
+
+/**
+ * @brief FrameFarm::next
+ * @return the shardable operator fed by op alone, on its first input,
+ * if op is needed by nothing else
+ */
+Operator *FrameFarm::next(Operator *op)
+{
+    Operator *sink = NULL;
+    QVector<OperatorOutput*> outputs = op->getOutputs();
+    for (int i = 0 ; i < outputs.count() ; ++i ) {
+        QSet<OperatorInput*> sinks = outputs[i]->sinks();
+        if ( sinks.isEmpty() )
+            continue;
+        /* op would have to be played in this process too */
+        if ( i != 0 || sinks.count() != 1 )
+            return NULL;
+        OperatorInput *input = *sinks.begin();
+        Operator *candidate = input->m_operator;
+        if ( !candidate->isEnabled() ||
+             !candidate->isShardable() ||
+             candidate->getInputs().indexOf(input) != 0 ||
+             input->sources().count() != 1 )
+            return NULL;
+        sink = candidate;
+    }
+    return sink;
+}
+
+void FrameFarm::shardRange(int count, int index, int shards, int &begin, int &end)
+{
+    begin = qint64(count) * index / shards;
+    end = qint64(count) * (index + 1) / shards;
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#ifndef FRAMEFARM_H
+#define FRAMEFARM_H
+
+#include <QObject>
+#include <QVector>
+#include <QStringList>
+
+class Process;
+class Operator;
+class OperatorParameterFilesCollection;
+
+/**
+ * @brief The FrameFarm class splits the frames of the 1:1 stages of a
+ * headless process between several darkflow-cli processes. Each child loads
+ * the same project, keeps its shard of the files of the source and plays the
+ * last shardable operator of the chain, the results come back through
+ * mapped result files and are merged, in sequence number order, as the
+ * results of that operator before the fan-in operators run in this process.
+ * The other inputs of the chain, master frames, are played once in this
+ * process and handed to the children the same way
+ */
+class FrameFarm : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief FrameFarm
+     * @param process a headless process, already loaded
+     * @param project the file process was loaded from, given to the children
+     * @param processes number of children per chain
+     */
+    FrameFarm(Process *process, const QString& project, int processes, QObject *parent = 0);
+
+    /**
+     * @brief plan
+     * @param targets operators that will be played, chains they do not
+     * depend on are left alone
+     * @return the number of chains found that are worth a farm
+     */
+    int plan(const QVector<Operator*>& targets);
+
+    /**
+     * @brief run plays the chains in the children and installs the merged
+     * results, the chains that failed are left to be played in this process
+     * @return false if a chain failed
+     */
+    bool run();
+
+    /* child side */
+    static bool shard(Process *process, const QString& source, int index, int count);
+    static bool writeResults(Process *process, const QString& target, const QString& filename);
+    /**
+     * @brief readResults installs the results written by writeResults() in
+     * another process, the operator is then up to date
+     */
+    static bool readResults(Process *process, const QString& target, const QString& filename);
+
+private:
+    typedef struct {
+        Operator *source;
+        Operator *target;
+        int frames;
+    } Chain;
+
+    Process *m_process;
+    QString m_project;
+    int m_processes;
+    QVector<Chain> m_chains;
+
+    bool runChain(const Chain& chain);
+    bool playInputs(const QVector<Operator*>& inputs);
+    static QVector<Operator*> chainInputs(const Chain& chain);
+    static Operator *findOperator(Process *process, const QString& uuid);
+    static OperatorParameterFilesCollection *filesCollection(Operator *op);
+    static Operator *next(Operator *op);
+    static void shardRange(int count, int index, int shards, int& begin, int& end);
+};
+
+#endif // FRAMEFARM_H
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QTimer>
+#include <QFileInfo>
+#include <cstdio>
+
+#include "preferences.h"
+#include "console.h"
+#include "process.h"
+#include "operator.h"
+#include "batchrunner.h"
+#include "profiler.h"
+#include "framefarm.h"
+#include "threadbudget.h"
+
+/*
+ * darkflow-cli project.dflow [-o operator]... [--trace trace.json] [-j processes]
+ *
+ * Loads a project without the graphical scene, plays the target
+ * operators (all the Save operators by default) and exits with
+ * 0 on success, 1 if a target failed, 2 on usage or load errors.
+ *
+ * With -j, the frames of the 1:1 stages are split between that many
+ * children, started with the --shard options
+ */
+int main(int argc, char *argv[])
+{
+    /* dialogs of the preferences and of the console are never shown,
+     * but they still need a platform plugin */
+    if ( qgetenv("QT_QPA_PLATFORM").isEmpty() )
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication a(argc, argv);
+    QApplication::setApplicationName("darkflow");
+    init_platform();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QApplication::tr("Play a DarkFlow project without user interface"));
+    parser.addHelpOption();
+    parser.addPositionalArgument("project", QApplication::tr("Project file to play"));
+    QCommandLineOption operatorOption(QStringList() << "o" << "operator",
+                                      QApplication::tr("Play the operator with that name or uuid, may be repeated. Defaults to all the Save operators"),
+                                      QApplication::tr("operator"));
+    QCommandLineOption listOption(QStringList() << "l" << "list",
+                                  QApplication::tr("List the operators of the project and exit"));
+    QCommandLineOption verboseOption(QStringList() << "v" << "verbose",
+                                     QApplication::tr("Log debug messages"));
+    parser.addOption(operatorOption);
+    parser.addOption(listOption);
+    QCommandLineOption traceOption(QStringList() << "t" << "trace",
+                                   QApplication::tr("Record the time spent by the operators and write it as a Chrome trace"),
+                                   QApplication::tr("file"));
+    QCommandLineOption processesOption(QStringList() << "j" << "processes",
+                                       QApplication::tr("Split the frames of the 1:1 stages between that many processes"),
+                                       QApplication::tr("count"));
+    QCommandLineOption threadsOption(QStringList() << "threads",
+                                     QApplication::tr("Number of threads of the parallel sections"),
+                                     QApplication::tr("count"));
+    QCommandLineOption shardOption(QStringList() << "shard",
+                                   QApplication::tr("Play only the shard index/count of the frames, used by --processes"),
+                                   QApplication::tr("index/count"));
+    QCommandLineOption shardSourceOption(QStringList() << "shard-source",
+                                         QApplication::tr("Operator whose files are sharded, used by --processes"),
+                                         QApplication::tr("uuid"));
+    QCommandLineOption shardOutputOption(QStringList() << "shard-output",
+                                         QApplication::tr("File the results of the target are written to, used by --processes"),
+                                         QApplication::tr("file"));
+    QCommandLineOption shardInputOption(QStringList() << "shard-input",
+                                        QApplication::tr("Results of an operator played by the parent, may be repeated, used by --processes"),
+                                        QApplication::tr("uuid=file"));
+    parser.addOption(verboseOption);
+    parser.addOption(traceOption);
+    parser.addOption(processesOption);
+    parser.addOption(threadsOption);
+    parser.addOption(shardOption);
+    parser.addOption(shardSourceOption);
+    parser.addOption(shardOutputOption);
+    parser.addOption(shardInputOption);
+    parser.process(a);
+
+    QStringList args = parser.positionalArguments();
+    if ( args.count() != 1 ) {
+        fprintf(stderr, "%s", parser.helpText().toLocal8Bit().constData());
+        return 2;
+    }
+
+    Console::init(true);
+    preferences = new Preferences();
+    if ( parser.isSet(verboseOption) )
+        Console::setLevel(Console::Debug);
+    Console::setRaiseLevel(Console::LastLevel);
+
+    Process *process = new Process(NULL);
+    if ( !process->load(args[0]) ) {
+        Console::flush();
+        return 2;
+    }
+
+    if ( parser.isSet(listOption) ) {
+        foreach(Operator *op, process->operators())
+            fprintf(stdout, "%s %s (%s)\n",
+                    op->uuid().toLocal8Bit().constData(),
+                    op->getName().toLocal8Bit().constData(),
+                    op->getClassIdentifier().toLocal8Bit().constData());
+        return 0;
+    }
+
+    if ( parser.isSet(traceOption) )
+        Profiler::instance()->setEnabled(true);
+    if ( parser.isSet(threadsOption) )
+        ThreadBudget::instance()->setThreads(parser.value(threadsOption).toInt());
+
+    bool shard = parser.isSet(shardOption);
+    if ( shard ) {
+        QStringList fraction = parser.value(shardOption).split('/');
+        if ( fraction.count() != 2 ||
+             !parser.isSet(shardSourceOption) ||
+             !parser.isSet(shardOutputOption) ||
+             parser.values(operatorOption).count() != 1 ||
+             !FrameFarm::shard(process, parser.value(shardSourceOption),
+                               fraction[0].toInt(), fraction[1].toInt()) ) {
+            Console::flush();
+            return 2;
+        }
+        foreach(const QString& input, parser.values(shardInputOption)) {
+            int sep = input.indexOf('=');
+            if ( sep < 0 ||
+                 !FrameFarm::readResults(process, input.left(sep), input.mid(sep + 1)) ) {
+                Console::flush();
+                return 2;
+            }
+        }
+    }
+
+    BatchRunner runner(process, parser.values(operatorOption));
+    QObject::connect(&runner, SIGNAL(finished(int)), &a, SLOT(quit()), Qt::QueuedConnection);
+    if ( !runner.resolveTargets() ) {
+        Console::flush();
+        return 2;
+    }
+    int processes = parser.value(processesOption).toInt();
+    if ( !shard && processes > 1 ) {
+        FrameFarm farm(process, QFileInfo(args[0]).absoluteFilePath(), processes);
+        if ( farm.plan(runner.targets()) )
+            farm.run();
+    }
+    if ( !runner.start() ) {
+        Console::flush();
+        return 2;
+    }
+    a.exec();
+    /* flush queued log messages */
+    Console::flush();
+    runner.printSummary();
+    if ( parser.isSet(traceOption) &&
+         !Profiler::instance()->writeTrace(parser.value(traceOption)) )
+        fprintf(stderr, "%s\n", QApplication::tr("Failed to write the trace to %0")
+                .arg(parser.value(traceOption)).toLocal8Bit().constData());
+    int ret = runner.exitCode();
+    if ( shard && ret == 0 &&
+         !FrameFarm::writeResults(process, runner.targets().first()->uuid(),
+                                  parser.value(shardOutputOption)) )
+        ret = 1;
+    delete process;
+    return ret;
+}
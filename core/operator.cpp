@@ -29,10 +29,12 @@
  *
  */
 #include <QThread>
+#include <QTimer>
 #include <QJsonArray>
 #include <QStringList>
 #include <QApplication>
 #include <QInputDialog>
+#include <QCryptographicHash>
 
 #include <cstdio>
 
@@ -44,6 +46,15 @@
 #include "operatorinput.h"
 #include "operatoroutput.h"
 #include "operatorworker.h"
+#include "operatorstreamworker.h"
+#include "operatorcacheworker.h"
+#include "resultcache.h"
+#include "photochannel.h"
+#include "preferences.h"
+#include "progresscounter.h"
+
+/* the GUI samples the progress of the workers at that period */
+#define DF_PROGRESS_INTERVAL 100
 
 Operator::Operator(const QString& classSection,
                    const char* docLink,
@@ -69,9 +80,19 @@ Operator::Operator(const QString& classSection,
     m_name(tr(classIdentifier)),
     m_tagsOverride(),
     m_thread(new QThread(this)),
-    m_worker(NULL)
+    m_worker(NULL),
+    m_streamTarget(),
+    m_streamOnly(false),
+    m_photoMemo(),
+    m_photoMemoKey(),
+    m_progressTimer(new QTimer(this)),
+    m_progress(),
+    m_progressP(0),
+    m_progressC(1)
 {
     connect(this, SIGNAL(setError(QString,QString)), this, SLOT(setErrorTag(QString,QString)), Qt::QueuedConnection);
+    m_progressTimer->setInterval(DF_PROGRESS_INTERVAL);
+    connect(m_progressTimer, SIGNAL(timeout()), this, SLOT(sampleProgress()));
 }
 
 Operator::~Operator()
@@ -120,13 +141,46 @@ void Operator::refreshInputs()
         emit stateChanged();
 }
 
-void Operator::workerProgress(int p, int c)
+void Operator::watchProgress()
+{
+    m_progress = m_worker->progressCounter();
+    m_progressP = 0;
+    m_progressC = 1;
+    m_progressTimer->start();
+}
+
+void Operator::unwatchProgress()
 {
-    emit progress(p,c);
+    /* the worker stored its final progress when it ended */
+    sampleProgress();
+    m_progressTimer->stop();
+    m_progress.reset();
+}
+
+/**
+ * @brief Operator::sampleProgress reads the counter of the running worker,
+ * the signal is only emitted when the value changed since the last sample
+ */
+void Operator::sampleProgress()
+{
+    if ( !m_progress )
+        return;
+    int p, c;
+    m_progress->get(p, c);
+    if ( p == m_progressP && c == m_progressC )
+        return;
+    m_progressP = p;
+    m_progressC = c;
+    emit progress(p, c);
 }
 
 void Operator::workerSuccess(QVector<QVector<Photo> > result)
 {
+    if ( isPipelinable() ) {
+        m_photoMemo = m_worker->photoMemo();
+        dflDebug(tr("%0 photos memoized").arg(m_photoMemo.count()));
+    }
+    unwatchProgress();
     m_thread->quit();
     m_worker=NULL;
     m_waitingParentFor = NotWaiting;
@@ -134,11 +188,10 @@ void Operator::workerSuccess(QVector<QVector<Photo> > result)
     int idx = 0;
     Q_ASSERT(m_outputs.count() == result.count());
     foreach(OperatorOutput *output, m_outputs) {
-        output->m_result.clear();
         if ( m_outputStatus[idx] == OutputEnabled )
-            foreach(Photo photo, result[idx]) {
-                output->m_result.push_back(photo);
-            }
+            output->setResult(result[idx]);
+        else
+            output->clearResult();
         ++idx;
     }
 
@@ -147,10 +200,16 @@ void Operator::workerSuccess(QVector<QVector<Photo> > result)
 
 void Operator::workerFailure()
 {
+    unwatchProgress();
     m_thread->quit();
     m_worker=NULL;
     m_waitingParentFor = NotWaiting;
     setOutOfDate();
+    /* the operators below waiting for us never get a worker */
+    foreach(OperatorOutput *output, m_outputs)
+        foreach(OperatorInput *sink, output->sinks())
+            sink->m_operator->failPipelines();
+    emit failed();
 }
 
 void Operator::parentUpToDate()
@@ -161,7 +220,18 @@ void Operator::parentUpToDate()
         play_parentDirty(WaitingForInputs);
         break;
     case WaitingForPlay:
-        play();
+        if ( m_streamTarget ) {
+            Operator *target = m_streamTarget;
+            m_streamTarget = NULL;
+            if ( m_streamOnly )
+                m_waitingParentFor = NotWaiting;
+            else
+                play();
+            target->play();
+        }
+        else {
+            play();
+        }
         break;
     default:
         dflWarning(tr("Unknown waiting reason"));
@@ -315,6 +385,11 @@ void Operator::setOutputStatus(int idx, Operator::OperatorOutputStatus status)
     m_outputStatus[idx] = status;
 }
 
+Operator::OperatorOutputStatus Operator::getOutputStatus(int idx) const
+{
+    return m_outputStatus[idx];
+}
+
 bool Operator::isCompatible(const Photo &photo) const
 {
     if ( photo.getScale() == Photo::Linear && (Linear & m_scaleCompatibility) )
@@ -340,6 +415,102 @@ void Operator::releaseAlgorithm(Algorithm *) const
 {
 }
 
+bool Operator::isStreamable() const
+{
+    return false;
+}
+
+bool Operator::isPipelinable() const
+{
+    return false;
+}
+
+bool Operator::isShardable() const
+{
+    return isPipelinable();
+}
+
+/**
+ * @brief Operator::isCacheable
+ * @return false if the results can not be found back from the parameters and
+ * the inputs alone, the operator and its descendants are then never cached
+ */
+bool Operator::isCacheable() const
+{
+    return true;
+}
+
+QByteArray Operator::configurationKey() const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(m_classIdentifier.toUtf8());
+    hash.addData(m_enabled ? "1" : "0");
+    foreach(OperatorParameter *parameter, m_parameters)
+        hash.addData(parameter->fingerprint());
+    foreach(OperatorOutputStatus status, m_outputStatus)
+        hash.addData(status == OutputEnabled ? "E" : "D");
+    return hash.result();
+}
+
+QByteArray Operator::cacheKey() const
+{
+    if ( !isCacheable() )
+        return QByteArray();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(configurationKey());
+    for(QMap<QString, QMap<QString, QString> >::const_iterator it = m_tagsOverride.begin() ;
+        it != m_tagsOverride.end() ;
+        ++it ) {
+        hash.addData(it.key().toUtf8());
+        for(QMap<QString, QString>::const_iterator tag = it.value().begin() ;
+            tag != it.value().end() ;
+            ++tag ) {
+            hash.addData(QString("%0=%1").arg(tag.key()).arg(tag.value()).toUtf8());
+        }
+    }
+    foreach(OperatorInput *input, m_inputs) {
+        QStringList sources;
+        foreach(OperatorOutput *output, input->sources()) {
+            QByteArray parentKey = output->m_operator->cacheKey();
+            if ( parentKey.isEmpty() )
+                return QByteArray();
+            int idx = output->m_operator->m_outputs.indexOf(output);
+            sources.push_back(QString("%0:%1").arg(QString(parentKey)).arg(idx));
+        }
+        sources.sort();
+        hash.addData(QString("[%0]").arg(sources.join(",")).toUtf8());
+    }
+    return hash.result().toHex();
+}
+
+/**
+ * @brief Operator::filterInput
+ * @param photo incoming photo, its identity gets a dedup postfix and the tags
+ * overrides are applied
+ * @param seen identities already seen for this run
+ * @return false if the photo must be dropped
+ */
+bool Operator::filterInput(Photo &photo, QMap<QString, int> &seen,
+                           const QMap<QString, QMap<QString, QString> > &tagsOverride) const
+{
+    QString identity = photo.getIdentity();
+    identity = identity.split('|').first();
+    int count = ++seen[identity];
+    if ( count > 1 )
+        identity+=QString("|%0").arg(count-1);
+    photo.setIdentity(identity);
+
+    QMap<QString, QMap<QString, QString> >::const_iterator tags = tagsOverride.find(identity);
+    if ( tags != tagsOverride.end() )
+        applyTagsOverride(photo, tags.value());
+    QString treatTag = photo.getTag(TAG_TREAT);
+    if ( treatTag == TAG_TREAT_ERROR ) {
+        dflWarning(tr("Photo: %0 discarded because of error").arg(photo.getIdentity()));
+        return false;
+    }
+    return treatTag != TAG_TREAT_DISCARDED;
+}
+
 QVector<QVector<Photo> > Operator::collectInputs()
 {
     QMap<QString, int> seen;
@@ -349,23 +520,9 @@ QVector<QVector<Photo> > Operator::collectInputs()
     foreach(OperatorInput *input, m_inputs) {
         inputs.push_back(QVector<Photo>());
         foreach(OperatorOutput *source, input->sources()) {
-            foreach(Photo photo, source->m_result) {
-                QString identity = photo.getIdentity();
-                identity = identity.split('|').first();
-                int count = ++seen[identity];
-                if ( count > 1 )
-                    identity+=QString("|%0").arg(count-1);
-                photo.setIdentity(identity);
-
-                overrideTags(photo);
-                QString treatTag = photo.getTag(TAG_TREAT);
-                if ( treatTag != TAG_TREAT_DISCARDED &&
-                     treatTag != TAG_TREAT_ERROR) {
+            foreach(Photo photo, source->getResult()) {
+                if ( filterInput(photo, seen, m_tagsOverride) )
                     inputs[i].push_back(photo);
-                }
-                else if ( treatTag == TAG_TREAT_ERROR ) {
-                    dflWarning(tr("Photo: %0 discarded because of error").arg(photo.getIdentity()));
-                }
             }
         }
         ++i;
@@ -373,6 +530,83 @@ QVector<QVector<Photo> > Operator::collectInputs()
     return inputs;
 }
 
+/**
+ * @brief Operator::streamChain
+ * @return the operators, upstream first and ending on this one, that can
+ * run in a single strip pass, or an empty chain
+ */
+QVector<Operator *> Operator::streamChain()
+{
+    QVector<Operator*> chain;
+    if ( !preferences->getStreaming() || !isStreamable() )
+        return chain;
+    Operator *op = this;
+    chain.push_front(op);
+    for (;;) {
+        QSet<OperatorOutput*> sources = op->m_inputs[0]->sources();
+        if ( sources.count() != 1 || !op->m_tagsOverride.isEmpty() )
+            break;
+        OperatorOutput *parentOutput = *sources.begin();
+        Operator *parent = parentOutput->m_operator;
+        if ( !parent->isStreamable() ||
+             parent->isUpToDate() ||
+             parent->m_worker ||
+             parent->m_waitingParentFor != NotWaiting ||
+             parent->m_outputStatus[0] != OutputEnabled ||
+             parentOutput->sinks().count() != 1 )
+            break;
+        chain.push_front(parent);
+        op = parent;
+    }
+    if ( chain.count() < 2 )
+        chain.clear();
+    return chain;
+}
+
+/**
+ * @brief Operator::pipelineFrom
+ * @param head the operator whose inputs feed the worker of this operator
+ * @return a channel registered on the parent output of head, or NULL if
+ * head must wait for the whole parent batch
+ */
+std::shared_ptr<PhotoChannel> Operator::pipelineFrom(Operator *head)
+{
+    if ( !preferences->getPipelining() ||
+         !head->isPipelinable() ||
+         head->m_inputs.count() != 1 )
+        return std::shared_ptr<PhotoChannel>();
+    QSet<OperatorOutput*> sources = head->m_inputs[0]->sources();
+    if ( sources.count() != 1 )
+        return std::shared_ptr<PhotoChannel>();
+    OperatorOutput *parentOutput = *sources.begin();
+    Operator *parent = parentOutput->m_operator;
+    int idx = parent->m_outputs.indexOf(parentOutput);
+    if ( parent->isUpToDate() ||
+         parent->m_worker ||
+         parent->m_outputStatus[idx] != OutputEnabled )
+        return std::shared_ptr<PhotoChannel>();
+    std::shared_ptr<PhotoChannel> channel(new PhotoChannel(this, DF_PIPELINE_DEPTH));
+    parentOutput->addChannel(channel);
+    return channel;
+}
+
+/**
+ * @brief Operator::failPipelines closes with a failure the channels that
+ * pipelined consumers registered on this operator and on the ones below, as
+ * long as they did not get a worker to feed them
+ */
+void Operator::failPipelines()
+{
+    if ( m_worker )
+        return;
+    foreach(OperatorOutput *output, m_outputs) {
+        foreach(std::shared_ptr<PhotoChannel> channel, output->takeChannels())
+            channel->close(false);
+        foreach(OperatorInput *sink, output->sinks())
+            sink->m_operator->failPipelines();
+    }
+}
+
 void Operator::play() {
     Q_ASSERT(QThread::currentThread() == thread());
     if (m_worker) {
@@ -381,20 +615,128 @@ void Operator::play() {
     }
     if (isUpToDate())
         return;
-    if (play_parentDirty(WaitingForPlay))
+    QByteArray key;
+    if ( preferences->getResultCache() )
+        key = cacheKey();
+    if ( !key.isEmpty() && ResultCache::contains(key) ) {
+        // the parents do not even need to be up to date
+        dflDebug(tr("Cache hit for %0").arg(m_uuid));
+        m_waitingParentFor = NotWaiting;
+        m_streamOnly = false;
+        m_workerAboutToStart = true;
+        m_worker = new OperatorCacheWorker(key, m_thread, this);
+        QMap<const Operator*, int> lengths;
+        m_worker->setSchedulingHints(criticalPath(lengths), 0);
+        setOutOfDate();
+        m_worker->start(QVector<QVector<Photo> >(), m_outputStatus);
+        watchProgress();
+        m_workerAboutToStart = false;
+        return;
+    }
+    QVector<Operator*> chain = streamChain();
+    Operator *head = chain.isEmpty() ? this : chain.first();
+    std::shared_ptr<PhotoChannel> channel = pipelineFrom(head);
+    if ( channel ) {
+        // the parent feeds our worker photo by photo as soon as it runs
+        Operator *parent = (*head->m_inputs[0]->sources().begin())->m_operator;
+        parent->play();
+        m_waitingParentFor = NotWaiting;
+    }
+    else if ( head != this ) {
+        if ( head->play_parentDirty(WaitingForPlay) ) {
+            // the head will play us once its parents are up to date
+            head->m_streamTarget = this;
+            head->m_streamOnly = true;
+            emit progress(0, 1);
+            return;
+        }
+    }
+    else if (play_parentDirty(WaitingForPlay)) {
+        m_streamOnly = false;
         return;
+    }
     dflDebug("play on "+m_uuid);
     m_workerAboutToStart = true;
-    m_worker = newWorker();
+    if ( chain.isEmpty() )
+        m_worker = newWorker();
+    else {
+        dflDebug(tr("Streaming %0 operators").arg(chain.count()));
+        m_worker = new OperatorStreamWorker(chain, m_thread, this);
+    }
+    m_worker->setCacheKey(key);
+    if ( isPipelinable() ) {
+        /* the memo is only valid for the configuration that produced it */
+        QByteArray memoKey = configurationKey();
+        foreach(Operator *op, chain)
+            memoKey += op->configurationKey();
+        if ( memoKey != m_photoMemoKey ) {
+            m_photoMemo.clear();
+            m_photoMemoKey = memoKey;
+        }
+        m_worker->setPhotoMemo(m_photoMemo);
+    }
+    qint64 previousBytes = 0;
+    foreach(OperatorOutput *output, m_outputs)
+        previousBytes += output->resultFootprint();
     setOutOfDate();
-    m_worker->start(collectInputs(), m_outputStatus);
+    QMap<const Operator*, int> lengths;
+    if ( channel ) {
+        dflDebug(tr("Pipelined on %0").arg(channel->consumer()->m_uuid));
+        /* the footprint of the slot is measured on the photos popped */
+        m_worker->setSchedulingHints(criticalPath(lengths), 0);
+        m_worker->start(channel, head->m_tagsOverride, m_outputStatus);
+    }
+    else {
+        QVector<QVector<Photo> > inputs = head->collectInputs();
+        qint64 inputBytes = 0;
+        foreach(const QVector<Photo>& input, inputs)
+            inputBytes += footprint(input);
+        // outputs are assumed to weigh as much as the inputs, or as the last results
+        m_worker->setSchedulingHints(criticalPath(lengths),
+                                     inputBytes + qMax(inputBytes, previousBytes));
+        m_worker->start(inputs, m_outputStatus);
+    }
+    watchProgress();
     m_workerAboutToStart = false;
     dflDebug(tr("Worker started for %0").arg(m_uuid));
 }
 
+void Operator::dropPhotoMemo()
+{
+    m_photoMemo.clear();
+}
+
+/**
+ * @brief Operator::criticalPath
+ * @param lengths memoized lengths of the operators already visited
+ * @return the number of operators on the longest path to a sink
+ */
+int Operator::criticalPath(QMap<const Operator *, int> &lengths) const
+{
+    QMap<const Operator*, int>::const_iterator it = lengths.find(this);
+    if ( it != lengths.end() )
+        return it.value();
+    int length = 0;
+    foreach(OperatorOutput *output, m_outputs) {
+        foreach(OperatorInput *sink, output->sinks())
+            length = qMax(length, sink->m_operator->criticalPath(lengths));
+    }
+    lengths[this] = length + 1;
+    return length + 1;
+}
+
+qint64 Operator::footprint(const QVector<Photo> &photos)
+{
+    qint64 bytes = 0;
+    foreach(const Photo& photo, photos)
+        bytes += qint64(photo.image().columns()) * photo.image().rows() * sizeof(Magick::PixelPacket);
+    return bytes;
+}
+
 bool Operator::isUpToDate() const
 {
-    dflDebug(tr("%0 is up to date: %1").arg(m_uuid).arg(m_upToDate && !m_worker));
+    if ( Console::isEnabled(Console::Debug) )
+        dflDebug(tr("%0 is up to date: %1").arg(m_uuid).arg(m_upToDate && !m_worker));
     return m_upToDate;
 }
 
@@ -407,9 +749,21 @@ void Operator::setUpToDate()
 }
 
 void Operator::setOutOfDate()
+{
+    setOutOfDate(false);
+}
+
+/**
+ * @brief Operator::setOutOfDate
+ * @param upstreamStarting true when an upstream worker is about to start,
+ * running workers below are then pipelined on it and must be kept alive
+ */
+void Operator::setOutOfDate(bool upstreamStarting)
 {
     Q_ASSERT(QThread::currentThread() == thread());
     if ( m_worker && !m_workerAboutToStart ) {
+        if ( upstreamStarting )
+            return;
         dflDebug(tr("Sending 'stop' to worker"));
         stop();
         return;
@@ -417,11 +771,11 @@ void Operator::setOutOfDate()
     m_upToDate = false;
     QMap<Operator*,int> signaled;
     foreach(OperatorOutput *output, m_outputs) {
-        output->m_result.clear();
+        output->clearResult();
         foreach(OperatorInput *remoteInput, output->sinks()) {
             ++signaled[remoteInput->m_operator];
             if ( signaled[remoteInput->m_operator] == 1)
-                remoteInput->m_operator->setOutOfDate();
+                remoteInput->m_operator->setOutOfDate(upstreamStarting || m_workerAboutToStart);
         }
     }
     if ( !m_workerAboutToStart )
@@ -482,8 +836,12 @@ void Operator::overrideTags(Photo &photo)
     QString identity = photo.getIdentity();
     if (!photoTagsExists(identity))
         return;
-    QMap<QString, QString> tags = photoTags(identity);
-    for(QMap<QString, QString>::iterator it = tags.begin() ;
+    applyTagsOverride(photo, photoTags(identity));
+}
+
+void Operator::applyTagsOverride(Photo &photo, const QMap<QString, QString> &tags)
+{
+    for(QMap<QString, QString>::const_iterator it = tags.begin() ;
         it != tags.end() ;
         ++it ) {
         if ( it.value().count() == 0 )
@@ -604,11 +962,13 @@ void Operator::load(QJsonObject &obj)
 
 static void logMessage(Console::Level level, const QString& who, const QString& msg)
 {
-    dflMessage(level, who+": "+msg);
+    dflMessage(level, who, msg);
 }
 
 void Operator::dflDebug(const char *fmt, ...) const
 {
+    if ( !Console::isEnabled(Console::Debug) )
+        return;
     va_list ap;
     char *msg;
     int ret;
@@ -622,6 +982,8 @@ void Operator::dflDebug(const char *fmt, ...) const
 
 void Operator::dflInfo(const char *fmt, ...) const
 {
+    if ( !Console::isEnabled(Console::Info) )
+        return;
     va_list ap;
     char *msg;
     int ret;
@@ -635,6 +997,8 @@ void Operator::dflInfo(const char *fmt, ...) const
 
 void Operator::dflWarning(const char *fmt, ...) const
 {
+    if ( !Console::isEnabled(Console::Warning) )
+        return;
     va_list ap;
     char *msg;
     int ret;
@@ -648,6 +1012,8 @@ void Operator::dflWarning(const char *fmt, ...) const
 
 void Operator::dflError(const char *fmt, ...) const
 {
+    if ( !Console::isEnabled(Console::Error) )
+        return;
     va_list ap;
     char *msg;
     int ret;
@@ -661,6 +1027,8 @@ void Operator::dflError(const char *fmt, ...) const
 
 void Operator::dflCritical(const char *fmt, ...) const
 {
+    if ( !Console::isEnabled(Console::Critical) )
+        return;
     va_list ap;
     char *msg;
     int ret;
@@ -35,11 +35,14 @@
 #include <QVector>
 #include <QMap>
 #include <QSet>
+#include <QPointer>
+#include <memory>
 #include <QString>
 #include <QJsonObject>
 
 #include "ports.h"
 #include "photo.h"
+#include "photomemo.h"
 
 class OperatorParameter;
 class OperatorInput;
@@ -47,6 +50,9 @@ class OperatorOutput;
 class Process;
 class QThread;
 class OperatorWorker;
+class PhotoChannel;
+class ProgressCounter;
+class QTimer;
 
 #define OP_SECTION_ASSETS           Operator::tr("Assets"), "/docs/assets.%0/#%1"
 #define OP_SECTION_WORKFLOW         Operator::tr("Workflow"), "/docs/workflow.%0/#%1"
@@ -147,19 +153,86 @@ public:
     void addOutput(OperatorOutput* output);
     void addParameter(OperatorParameter* parameter);
     void setOutputStatus(int idx, OperatorOutputStatus status);
+    OperatorOutputStatus getOutputStatus(int idx) const;
     bool isCompatible(const Photo& photo) const;
     bool isCompatible(const ScaleCompatibility& comp) const;
 
     virtual Algorithm *getAlgorithm() const;
     virtual void releaseAlgorithm(Algorithm *) const;
+    /**
+     * @brief isStreamable
+     * @return true if getAlgorithm() returns a point-wise algorithm
+     * that does all the work of the operator
+     */
+    virtual bool isStreamable() const;
+    /**
+     * @brief isPipelinable
+     * @return true if the worker processes its photos one by one with the
+     * default play_onInput(), so that it can start on the first photo
+     * while the upstream operator is still producing the others.
+     * Operators that need the full set (Integration, Scale, registration...)
+     * keep the default
+     */
+    virtual bool isPipelinable() const;
+
+    /**
+     * @brief isShardable
+     * @return true if each photo of the first input gives its own outputs,
+     * whatever the other photos of that input are. The other inputs, master
+     * frames, are used whole. Such operators can run in separate processes
+     * on disjoint shards of the frames
+     */
+    virtual bool isShardable() const;
+
+    /**
+     * @brief isCacheable
+     * @return false if the operator has side effects (writes files...)
+     * and must not be skipped by the result cache
+     */
+    virtual bool isCacheable() const;
+
+    /**
+     * @brief cacheKey
+     * @return a content address of the results, derived from the class,
+     * the parameters, the tag overrides and the keys of all the sources.
+     * Empty if the operator or one of its ancestors is not cacheable
+     */
+    QByteArray cacheKey() const;
+    /**
+     * @brief configurationKey
+     * @return a digest of the class, the parameters and the outputs status,
+     * the part of the cache key that does not depend on the inputs
+     */
+    QByteArray configurationKey() const;
+
+    /**
+     * @brief dropPhotoMemo releases the photos kept for incremental runs
+     */
+    void dropPhotoMemo();
+
+    bool filterInput(Photo& photo, QMap<QString, int>& seen,
+                     const QMap<QString, QMap<QString, QString> >& tagsOverride) const;
 
 private:
     QVector<QVector<Photo> > collectInputs();
+    QVector<Operator*> streamChain();
+    std::shared_ptr<PhotoChannel> pipelineFrom(Operator *head);
+    void failPipelines();
+    void setOutOfDate(bool upstreamStarting);
+    static void applyTagsOverride(Photo& photo, const QMap<QString, QString>& tags);
+    int criticalPath(QMap<const Operator*, int>& lengths) const;
+    static qint64 footprint(const QVector<Photo>& photos);
+    void watchProgress();
+    void unwatchProgress();
+
+private slots:
+    void sampleProgress();
 
 signals:
     void progress(int ,int );
     void upToDate();
     void outOfDate();
+    void failed();
     void stateChanged();
     void setError(const QString& photoIdentity, const QString& msg);
 
@@ -171,7 +244,6 @@ public slots:
     void stop();
     void clone();
     void refreshInputs();
-    void workerProgress(int p, int c);
     void workerSuccess(QVector<QVector<Photo> > result);
     void workerFailure();
     void parentUpToDate();
@@ -229,6 +301,14 @@ protected:
 
     QThread *m_thread;
     OperatorWorker *m_worker;
+    QPointer<Operator> m_streamTarget;
+    bool m_streamOnly;
+    PhotoMemo m_photoMemo;
+    QByteArray m_photoMemoKey;
+    QTimer *m_progressTimer;
+    std::shared_ptr<ProgressCounter> m_progress;
+    int m_progressP;
+    int m_progressC;
 
 };
 
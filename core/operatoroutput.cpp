@@ -28,10 +28,60 @@
  *     * Guillaume Gimenez <guillaume@blackmilk.fr>
  *
  */
+#include <QFile>
+#include <QThread>
+#include <QAtomicInt>
+
 #include "operator.h"
 #include "operatorinput.h"
 #include "operatoroutput.h"
 #include "photo.h"
+#include "photochannel.h"
+#include "resultstore.h"
+#include "resultcache.h"
+#include "console.h"
+
+/**
+ * @brief The SpillWriter class writes spilled results away from the main
+ * thread. A discarded writer deletes itself and its file once it is done
+ */
+class SpillWriter : public QThread
+{
+public:
+    SpillWriter(const QString& filename, const QVector<Photo>& result) :
+        QThread(),
+        m_filename(filename),
+        m_result(result),
+        m_success(false),
+        m_discarded(0)
+    {}
+    ~SpillWriter()
+    {
+        if ( m_discarded.load() )
+            QFile::remove(m_filename);
+    }
+    bool success() const { return m_success; }
+    void discard()
+    {
+        m_discarded.store(1);
+        connect(this, SIGNAL(finished()), this, SLOT(deleteLater()));
+        if ( isFinished() )
+            deleteLater();
+    }
+
+protected:
+    void run()
+    {
+        m_success = ResultCache::write(m_filename, QVector<QVector<Photo> >() << m_result);
+        /* the pixels are released by the main thread, not here */
+    }
+
+private:
+    QString m_filename;
+    QVector<Photo> m_result;
+    bool m_success;
+    QAtomicInt m_discarded;
+};
 
 OperatorOutput::OperatorOutput(const QString &name,
                                Operator *parent) :
@@ -39,12 +89,20 @@ OperatorOutput::OperatorOutput(const QString &name,
     m_operator(parent),
     m_name(name),
     m_sinks(),
-    m_result()
+    m_channels(),
+    m_result(),
+    m_resultCount(0),
+    m_resultBytes(0),
+    m_spilled(false),
+    m_spilling(NULL),
+    m_spillFilename(),
+    m_spillSerial(0)
 {
 }
 
 OperatorOutput::~OperatorOutput()
 {
+    clearResult();
 }
 
 QString OperatorOutput::name() const
@@ -67,9 +125,118 @@ void OperatorOutput::removeSink(OperatorInput *input)
     m_sinks.remove(input);
 }
 
-QVector<Photo> OperatorOutput::getResult() const
+QVector<Photo> OperatorOutput::getResult()
 {
+    /* needed again, the results stay in memory */
+    cancelSpill();
+    if ( m_spilled ) {
+        /* the photos are copied out of the mapped file */
+        QVector<QVector<Photo> > result(1);
+        if ( ResultCache::read(m_spillFilename, result) )
+            m_result = result[0];
+        else
+            dflError(tr("Could not read back %0").arg(m_spillFilename));
+        QFile::remove(m_spillFilename);
+        m_spilled = false;
+    }
+    if ( m_resultCount )
+        ResultStore::instance()->touch(this);
     return m_result;
 }
 
+void OperatorOutput::setResult(const QVector<Photo> &result)
+{
+    clearResult();
+    m_result = result;
+    m_resultCount = result.count();
+    foreach(const Photo& photo, result)
+        m_resultBytes += photo.pixelBytes();
+    if ( m_resultCount )
+        ResultStore::instance()->touch(this);
+}
 
+void OperatorOutput::clearResult()
+{
+    ResultStore::instance()->forget(this);
+    cancelSpill();
+    if ( m_spilled )
+        QFile::remove(m_spillFilename);
+    m_spilled = false;
+    m_result.clear();
+    m_resultCount = 0;
+    m_resultBytes = 0;
+}
+
+int OperatorOutput::resultCount() const
+{
+    return m_resultCount;
+}
+
+qint64 OperatorOutput::resultFootprint() const
+{
+    return m_resultBytes;
+}
+
+bool OperatorOutput::isSpilled() const
+{
+    return m_spilled;
+}
+
+void OperatorOutput::spill()
+{
+    if ( m_spilled || m_spilling || m_result.isEmpty() )
+        return;
+    m_spillFilename = ResultStore::instance()->spillFilename(this, ++m_spillSerial);
+    m_spilling = new SpillWriter(m_spillFilename, m_result);
+    connect(m_spilling, SIGNAL(finished()), this, SLOT(spillFinished()));
+    m_spilling->start(QThread::LowPriority);
+}
+
+void OperatorOutput::cancelSpill()
+{
+    if ( !m_spilling )
+        return;
+    disconnect(m_spilling, 0, this, 0);
+    m_spilling->discard();
+    m_spilling = NULL;
+}
+
+void OperatorOutput::spillFinished()
+{
+    /* a cancelled writer may have been queued before it was disconnected */
+    if ( sender() != m_spilling )
+        return;
+    SpillWriter *writer = m_spilling;
+    m_spilling = NULL;
+    writer->deleteLater();
+    if ( !writer->success() ) {
+        dflWarning(tr("Could not spill results to %0").arg(m_spillFilename));
+        return;
+    }
+    dflDebug(tr("Results of %0 spilled to disk").arg(m_operator->getName()));
+    m_result.clear();
+    m_spilled = true;
+    /* memoized photos would keep the pixels in memory */
+    m_operator->dropPhotoMemo();
+    foreach(OperatorInput *sink, m_sinks)
+        sink->m_operator->dropPhotoMemo();
+}
+
+
+
+void OperatorOutput::addChannel(std::shared_ptr<PhotoChannel> channel)
+{
+    m_channels.push_back(channel);
+}
+
+/**
+ * @brief OperatorOutput::takeChannels
+ * @return the channels registered by pipelined consumers, to be fed by the
+ * worker about to start
+ */
+QVector<std::shared_ptr<PhotoChannel> > OperatorOutput::takeChannels()
+{
+    QVector<std::shared_ptr<PhotoChannel> > channels = m_channels;
+    m_channels.clear();
+    return channels;
+}
@@ -35,11 +35,14 @@
 #include <QObject>
 #include <QString>
 #include <QSet>
+#include <memory>
 
 #include "photo.h"
 
 class Operator;
 class OperatorInput;
+class PhotoChannel;
+class SpillWriter;
 
 class OperatorOutput : public QObject
 {
@@ -54,17 +57,44 @@ public:
     QSet<OperatorInput *> sinks() const;
     void addSink(OperatorInput *input);
     void removeSink(OperatorInput *input);
-    QVector<Photo> getResult() const;
+    /**
+     * @brief getResult
+     * @return the photos of the last run, read back from disk if they
+     * had been spilled by the ResultStore
+     */
+    QVector<Photo> getResult();
+    void setResult(const QVector<Photo>& result);
+    void clearResult();
+    int resultCount() const;
+    qint64 resultFootprint() const;
+    bool isSpilled() const;
+    /**
+     * @brief spill writes the results to a file from a background thread,
+     * they are released once written
+     */
+    void spill();
+
+    void addChannel(std::shared_ptr<PhotoChannel> channel);
+    QVector<std::shared_ptr<PhotoChannel> > takeChannels();
 
 public:
     Operator *m_operator;
 private:
     QString m_name;
     QSet<OperatorInput*> m_sinks;
-public:
+    QVector<std::shared_ptr<PhotoChannel> > m_channels;
     QVector<Photo> m_result;
+    int m_resultCount;
+    qint64 m_resultBytes;
+    bool m_spilled;
+    SpillWriter *m_spilling;
+    QString m_spillFilename;
+    int m_spillSerial;
+
+    void cancelSpill();
 
-public slots:
+private slots:
+    void spillFinished();
 };
 
 #endif // OPERATOROUTPUT_H
@@ -28,6 +28,9 @@
  *     * Guillaume Gimenez <guillaume@blackmilk.fr>
  *
  */
+#include <QJsonDocument>
+#include <QDir>
+
 #include "operatorparameter.h"
 
 OperatorParameter::OperatorParameter(
@@ -50,5 +53,7 @@ QString OperatorParameter::name() const
     return m_name;
 }
 
-
-
+QByteArray OperatorParameter::fingerprint()
+{
+    return QJsonDocument(save(QDir::rootPath())).toJson(QJsonDocument::Compact);
+}
@@ -34,6 +34,7 @@
 #include <QObject>
 #include <QString>
 #include <QJsonObject>
+#include <QByteArray>
 
 #include "operator.h"
 
@@ -47,6 +48,12 @@ public:
 
     virtual QJsonObject save(const QString& baseDirStr) = 0;
     virtual void load(const QJsonObject& obj) = 0;
+    /**
+     * @brief fingerprint
+     * @return a stable byte representation of the value, used to build
+     * the result cache key of the operator
+     */
+    virtual QByteArray fingerprint();
 
     QString caption() const;
 
@@ -33,6 +33,8 @@
 #include "operatorparameterfilescollection.h"
 #include "console.h"
 #include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
 
 OperatorParameterFilesCollection::OperatorParameterFilesCollection(
         const QString& name,
@@ -99,6 +101,22 @@ QJsonObject OperatorParameterFilesCollection::save(const QString& baseDirStr)
     return obj;
 }
 
+/**
+ * @brief OperatorParameterFilesCollection::fingerprint
+ * @return the file list along with sizes and modification times, so that
+ * a file rewritten in place invalidates the cached results
+ */
+QByteArray OperatorParameterFilesCollection::fingerprint()
+{
+    QByteArray fp = OperatorParameter::fingerprint();
+    foreach(const QString& file, m_collection) {
+        QFileInfo info(file);
+        fp += QString("|%0:%1").arg(info.size())
+                .arg(info.lastModified().toMSecsSinceEpoch()).toUtf8();
+    }
+    return fp;
+}
+
 void OperatorParameterFilesCollection::load(const QJsonObject &obj)
 {
     if ( obj["type"].toString() != "filesCollection" ) {
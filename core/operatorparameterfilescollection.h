@@ -58,6 +58,7 @@ public:
 
     QJsonObject save(const QString& baseDirStr);
     void load(const QJsonObject &obj);
+    QByteArray fingerprint();
 
 signals:
     void updated();
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#include <Magick++.h>
+
+#include "operatorstreamworker.h"
+#include "operator.h"
+#include "algorithm.h"
+#include "lutbased.h"
+#include "photo.h"
+#include "console.h"
+
+/* strips are sized to stay in L2 while all the stages run over them */
+#define DF_STREAM_STRIP_SIZE (256*1024)
+
+OperatorStreamWorker::OperatorStreamWorker(const QVector<Operator *> &chain, QThread *thread, Operator *op) :
+    OperatorWorker(thread, op),
+    m_chain(chain),
+    m_algorithms()
+{
+    foreach(Operator *stage, m_chain)
+        m_algorithms.push_back(stage->getAlgorithm());
+}
+
+OperatorStreamWorker::~OperatorStreamWorker()
+{
+    for (int i = 0 ; i < m_chain.count() ; ++i )
+        m_chain[i]->releaseAlgorithm(m_algorithms[i]);
+}
+
+Photo OperatorStreamWorker::process(const Photo &photo, int, int)
+{
+    Photo newPhoto(photo);
+    int n_stages = m_algorithms.count();
+    QVector<bool> hdr(n_stages);
+    for (int i = 0 ; i < n_stages ; ++i ) {
+        hdr[i] = newPhoto.getScale() == Photo::HDR;
+        m_algorithms[i]->applyOnTags(newPhoto);
+    }
+
+    QVector<Pass> passes = fuse(hdr);
+
+    Magick::Image& image = newPhoto.image();
+    image.modifyImage();
+    int h = image.rows(),
+            w = image.columns();
+    int rows = qMax(1, int(DF_STREAM_STRIP_SIZE/(w*sizeof(Magick::PixelPacket))));
+    int n_strips = (h+rows-1)/rows;
+    std::shared_ptr<FramePixels> pixel_cache(new FramePixels(image, true));
+    dfl_block bool error=false;
+    dfl_parallel_for(s, 0, n_strips, 1, (), {
+        int y = s*rows;
+        int strip_rows = qMin(rows, h-y);
+        Magick::PixelPacket *pixels = pixel_cache->get(y,strip_rows);
+        if ( error || !pixels ) {
+            if ( !error )
+                dflError(DF_NULL_PIXELS);
+            error=true;
+            continue;
+        }
+        foreach(const Pass& pass, passes) {
+            if ( pass.algorithm )
+                pass.algorithm->applyOnPixels(pixels, pixels, w*strip_rows, pass.hdr);
+            else
+                LutBased::applyLut(pass.lut.constData(), pixels, pixels, w*strip_rows);
+        }
+        pixel_cache->sync();
+    });
+    if ( error ) {
+        setError(photo, DF_NULL_PIXELS);
+        return newPhoto;
+    }
+
+    for (int i = 0 ; i < n_stages ; ++i )
+        if ( m_algorithms[i]->altersCurve() )
+            m_algorithms[i]->applyOnCurve(newPhoto, hdr[i]);
+
+    return newPhoto;
+}
+
+QVector<OperatorStreamWorker::Pass> OperatorStreamWorker::fuse(const QVector<bool> &hdr)
+{
+    QVector<Pass> passes;
+    int n_stages = m_algorithms.count();
+    for (int i = 0 ; i < n_stages ; ) {
+        int j = i;
+        while ( j < n_stages && m_algorithms[j]->channelLut(hdr[j]) )
+            ++j;
+        Pass pass;
+        if ( j - i < 2 ) {
+            pass.algorithm = m_algorithms[i];
+            pass.hdr = hdr[i];
+            passes.push_back(pass);
+            ++i;
+            continue;
+        }
+        /* a run of look-up tables is folded into a single one, each stage
+         * contributing the table of the scale it sees */
+        pass.algorithm = NULL;
+        pass.hdr = false;
+        pass.lut.resize(QuantumRange+1);
+        quantum_t *lut = pass.lut.data();
+        for ( int v = 0 ; v <= QuantumRange ; ++v )
+            lut[v] = v;
+        for ( ; i < j ; ++i )
+            LutBased::compose(lut, m_algorithms[i]->channelLut(hdr[i]).get());
+        for ( int v = 0 ; v <= QuantumRange ; ++v )
+            lut[v] = clamp(lut[v]);
+        passes.push_back(pass);
+    }
+    return passes;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#ifndef OPERATORSTREAMWORKER_H
+#define OPERATORSTREAMWORKER_H
+
+#include <QObject>
+#include <QVector>
+
+#include "operatorworker.h"
+
+class Algorithm;
+
+/**
+ * @brief The OperatorStreamWorker class runs a chain of point-wise operators
+ * strip by strip, each strip going through the whole chain while it is hot
+ * in cache. Intermediate frames are never materialized, and consecutive
+ * look-up tables are applied as one.
+ */
+class OperatorStreamWorker : public OperatorWorker
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief OperatorStreamWorker
+     * @param chain operators from upstream to downstream, the last one is op
+     */
+    OperatorStreamWorker(const QVector<Operator*>& chain, QThread *thread, Operator *op);
+    ~OperatorStreamWorker();
+
+protected:
+    Photo process(const Photo &photo, int p, int c);
+
+private:
+    struct Pass {
+        Algorithm *algorithm;
+        bool hdr;
+        QVector<quantum_t> lut;
+    };
+    QVector<Pass> fuse(const QVector<bool>& hdr);
+
+    QVector<Operator*> m_chain;
+    QVector<Algorithm*> m_algorithms;
+};
+
+#endif // OPERATORSTREAMWORKER_H
@@ -40,6 +40,9 @@
 #include "photo.h"
 #include "preferences.h"
 #include "hdr.h"
+#include "photochannel.h"
+#include "resultcache.h"
+#include "profiler.h"
 
 static struct AtStart {
     AtStart() {
@@ -54,7 +57,19 @@ OperatorWorker::OperatorWorker(QThread *thread, Operator *op) :
     m_inputs(),
     m_outputs(),
     m_outputStatus(),
+    m_channels(),
+    m_channel(),
+    m_tagsOverride(),
     m_elapsed(),
+    m_workerAcquired(false),
+    m_slotFootprint(0),
+    m_cacheKey(),
+    m_priority(0),
+    m_footprint(0),
+    m_memoize(false),
+    m_previousMemo(),
+    m_memo(),
+    m_progress(new ProgressCounter),
     m_signalEmited(false),
     m_error(false),
     m_earlyAbort(false)
@@ -62,7 +77,6 @@ OperatorWorker::OperatorWorker(QThread *thread, Operator *op) :
     moveToThread(thread);
     connect(m_thread, SIGNAL(finished()), this, SLOT(finished()));
     connect(this, SIGNAL(doStart()), this, SLOT(started()));
-    connect(this, SIGNAL(progress(int,int)), m_operator, SLOT(workerProgress(int,int)));
     connect(this, SIGNAL(success(QVector<QVector<Photo> >)), m_operator, SLOT(workerSuccess(QVector<QVector<Photo> >)));
     connect(this, SIGNAL(failure()), m_operator, SLOT(workerFailure()));
     m_thread->start();
@@ -74,15 +88,45 @@ void OperatorWorker::start(QVector<QVector<Photo> > inputs, QVector<Operator::Op
     prepareOutputs(outputStatus);
     emit doStart();
 }
+
+/**
+ * @brief OperatorWorker::start pipelined start, the photos are popped from
+ * the channel while the upstream worker produces them
+ */
+void OperatorWorker::start(std::shared_ptr<PhotoChannel> channel,
+                           const QMap<QString, QMap<QString, QString> > &tagsOverride,
+                           QVector<Operator::OperatorOutputStatus> outputStatus)
+{
+    m_channel = channel;
+    m_tagsOverride = tagsOverride;
+    m_inputs.push_back(QVector<Photo>());
+    prepareOutputs(outputStatus);
+    emit doStart();
+}
+
 void OperatorWorker::started()
 {
-    bool ret = preferences->acquireWorker(this);
-    if ( !ret ) {
+    /* a pipelined worker mostly waits for its upstream worker, it only
+     * takes a slot when it has photos to process, see play_onChannel() */
+    if ( !m_channel && !acquireSlot(m_footprint) ) {
         emitFailure();
         return;
     }
     m_elapsed.start();
+    ProfileScope scope("operator", m_operator->getName());
     play();
+    if ( scope.active() ) {
+        qint64 bytes = 0;
+        int photos = 0;
+        foreach(const QVector<Photo>& output, m_outputs) {
+            photos += output.count();
+            foreach(const Photo& photo, output)
+                bytes += photo.pixelBytes();
+        }
+        scope.setArg("photos", photos);
+        scope.setArg("bytes", bytes);
+        scope.setArg("error", m_error);
+    }
 }
 
 int OperatorWorker::outputsCount()
@@ -90,11 +134,20 @@ int OperatorWorker::outputsCount()
     return m_outputs.count();
 }
 
+bool OperatorWorker::outputEnabled(int idx) const
+{
+    return idx < m_outputStatus.count() &&
+            m_outputStatus[idx] == Operator::OutputEnabled;
+}
+
 void OperatorWorker::outputPush(int idx, const Photo &photo)
 {
     if ( idx < m_outputs.count() ) {
-        if ( m_outputStatus[idx] == Operator::OutputEnabled )
+        if ( m_outputStatus[idx] == Operator::OutputEnabled ) {
             m_outputs[idx].push_back(photo);
+            foreach(std::shared_ptr<PhotoChannel> channel, m_channels[idx])
+                channel->push(photo, this);
+        }
     }
     else {
         dflCritical(tr("OutputPush idx out of range"));
@@ -140,7 +193,33 @@ void OperatorWorker::finished()
     else { //signal emited, safe to delete
         deleteLater();
     }
-    preferences->releaseWorker();
+    releaseSlot();
+}
+
+bool OperatorWorker::acquireSlot(qint64 footprint)
+{
+    if ( m_workerAcquired )
+        return true;
+    ProfileScope wait("scheduler", tr("Waiting: %0").arg(m_operator->getName()));
+    if ( !preferences->acquireWorker(this, m_priority, footprint) )
+        return false;
+    m_workerAcquired = true;
+    m_slotFootprint = footprint;
+    return true;
+}
+
+bool OperatorWorker::acquireSlot()
+{
+    return acquireSlot(m_slotFootprint);
+}
+
+bool OperatorWorker::releaseSlot()
+{
+    if ( !m_workerAcquired )
+        return false;
+    m_workerAcquired = false;
+    preferences->releaseWorker(this);
+    return true;
 }
 
 bool OperatorWorker::aborted() {
@@ -149,25 +228,76 @@ bool OperatorWorker::aborted() {
 
 void OperatorWorker::emitFailure() {
     m_signalEmited = true;
-    emit progress(0, 1);
+    setProgress(0, 1);
     emit failure();
+    closeChannels(false);
     if ( ( m_earlyAbort || aborted() ) && !m_error )
         dflDebug(tr("Aborted (after %0ms)").arg(m_elapsed.elapsed()));
     else
         dflError(tr("Failure (after %0ms)").arg(m_elapsed.elapsed()));
 }
 
+void OperatorWorker::setCacheKey(const QByteArray &key)
+{
+    m_cacheKey = key;
+}
+
+void OperatorWorker::setSchedulingHints(int priority, qint64 footprint)
+{
+    m_priority = priority;
+    m_footprint = footprint;
+}
+
+void OperatorWorker::setPhotoMemo(const PhotoMemo &memo)
+{
+    m_memoize = true;
+    m_previousMemo = memo;
+}
+
+PhotoMemo OperatorWorker::photoMemo() const
+{
+    return m_memo;
+}
+
 void OperatorWorker::emitSuccess()
 {
+    /* stored before success is emitted, the operator may start
+     * a new worker right after */
+    if ( !m_cacheKey.isEmpty() && !m_error &&
+         m_elapsed.elapsed() >= DF_CACHE_MIN_ELAPSED ) {
+        if ( ResultCache::store(m_cacheKey, m_outputs) )
+            dflDebug(tr("Results cached as %0").arg(QString(m_cacheKey)));
+    }
     m_signalEmited = true;
-    emit progress(1, 1);
+    setProgress(1, 1);
     emit success(m_outputs);
+    closeChannels(true);
     dflInfo(tr("Success (after %0ms)").arg(m_elapsed.elapsed()));
 }
 
 void OperatorWorker::emitProgress(int p, int c, int sub_p, int sub_c)
 {
-    emit progress( p * sub_c + sub_p , c * sub_c);
+    m_progress->set( p * sub_c + sub_p , c * sub_c);
+}
+
+void OperatorWorker::setProgress(int p, int c)
+{
+    m_progress->set(p, c);
+}
+
+/**
+ * @brief OperatorWorker::advanceProgress
+ * @param steps units of the total set by the last setProgress/emitProgress,
+ * safe to call from the threads of a parallel loop
+ */
+void OperatorWorker::advanceProgress(int steps)
+{
+    m_progress->advance(steps);
+}
+
+std::shared_ptr<ProgressCounter> OperatorWorker::progressCounter() const
+{
+    return m_progress;
 }
 
 bool OperatorWorker::play_inputsAvailable()
@@ -184,8 +314,24 @@ void OperatorWorker::prepareOutputs(QVector<Operator::OperatorOutputStatus> outp
 {
     m_outputStatus = outputStatus;
     int n_outputs = outputStatus.count();
-    for (int i = 0 ; i < n_outputs ; ++i )
+    int expected = m_inputs.count() ? m_inputs[0].count() : 0;
+    QVector<OperatorOutput*> outputs = m_operator->getOutputs();
+    for (int i = 0 ; i < n_outputs ; ++i ) {
         m_outputs.push_back(QVector<Photo>());
+        m_channels.push_back(outputs[i]->takeChannels());
+        foreach(std::shared_ptr<PhotoChannel> channel, m_channels[i])
+            channel->setExpected(expected);
+    }
+}
+
+void OperatorWorker::closeChannels(bool success)
+{
+    for (int i = 0 ; i < m_channels.count() ; ++i )
+        foreach(std::shared_ptr<PhotoChannel> channel, m_channels[i])
+            channel->close(success);
+    m_channels.clear();
+    if ( m_channel )
+        m_channel->detach();
 }
 
 bool OperatorWorker::play_outputsAvailable()
@@ -205,6 +351,9 @@ void OperatorWorker::play_analyseSources()
 
 bool OperatorWorker::play_onInput(int idx)
 {
+    if ( m_channel )
+        return play_onChannel(false);
+
     int c = 0;
     int p = 0;
     c = m_inputs[idx].count();
@@ -220,65 +369,200 @@ bool OperatorWorker::play_onInput(int idx)
             emitFailure();
             return false;
         }
-        emit progress(p, c);
-        try {
-            Photo newPhoto;
-            if ( !m_operator->isCompatible(photo) ) {
-                switch ( preferences->getIncompatibleAction()) {
-                case Preferences::Warning:
-                    dflWarning(tr("Incompatible pixel scale: %0").arg(photo.getIdentity()));
-                    //Falls through
-                case Preferences::Ignore:
-                    if ( photo.getScale() == Photo::HDR )
-                        HDR(true).applyOn(photo);
-                    break;
-                default:
-                case Preferences::Error:
-                    setError(photo, tr("Incompatible pixel scale"));
-                    break;
-                }
-            }
-            if (!m_error) {
-                newPhoto = this->process(photo, p++, c);
-                if ( !newPhoto.isComplete() ) {
-                    dflDebug(tr("Photo is not complete, sending failure"));
-                    m_error = true;
-                    emitFailure();
-                    return false;
-                }
-            }
-            if ( !m_error )
-                m_outputs[0].push_back(newPhoto);
+        if ( !play_onPhoto(photo, p, c) )
+            return false;
+        if ( !m_error )
+            ++p;
+    }
+
+    if ( m_error || aborted() ) {
+        emitFailure();
+        return false;
+    }
+    emitSuccess();
+    return true;
+}
+
+/**
+ * @brief OperatorWorker::play_onChannel 1:1 processing of the photos
+ * popped from the channel until the upstream worker closes it. The worker
+ * holds a slot of the scheduler while it processes photos, and gives it
+ * back while it waits for the upstream worker
+ * @param parallel the photos already waiting in the channel are processed
+ * side by side, as play_onInputParallel() does
+ */
+bool OperatorWorker::play_onChannel(bool parallel)
+{
+    QMap<QString, int> seen;
+    int p = 0;
+    m_channel->attach();
+    forever {
+        if ( m_error ) {
+            dflDebug(tr("In error, sending failure"));
+            emitFailure();
+            return false;
         }
-        catch(std::exception &e) {
-            setError(photo, e.what());
+        if ( aborted() ) {
+            dflDebug(tr("Aborted, sending failure"));
             emitFailure();
             return false;
         }
+        Photo photo;
+        PhotoChannel::Status status = m_channel->pop(photo, 50);
+        if ( status == PhotoChannel::Timeout ) {
+            releaseSlot();
+            continue;
+        }
+        if ( status == PhotoChannel::Failed ) {
+            dflDebug(tr("Upstream failure, sending failure"));
+            emitFailure();
+            return false;
+        }
+        if ( status == PhotoChannel::Closed )
+            break;
+        if ( !m_operator->filterInput(photo, seen, m_tagsOverride) )
+            continue;
+        QVector<Photo> batch(1, photo);
+        int threads = parallel ? DfThreadLimit() : 1;
+        while ( batch.count() < threads ) {
+            Photo next;
+            /* closed and failed are seen again by the next pop */
+            if ( m_channel->pop(next, 0) != PhotoChannel::Popped )
+                break;
+            if ( m_operator->filterInput(next, seen, m_tagsOverride) )
+                batch.push_back(next);
+        }
+        /* the input and the output of each photo of the batch */
+        if ( !acquireSlot(2 * photo.pixelBytes() * threads) ) {
+            emitFailure();
+            return false;
+        }
+        int c = qMax(p + batch.count(), m_channel->expected());
+        for (int i = 0 ; i < m_channels.count() ; ++i )
+            foreach(std::shared_ptr<PhotoChannel> channel, m_channels[i])
+                channel->setExpected(c);
+        if ( parallel ) {
+            play_onBatch(batch, p, c);
+            continue;
+        }
+        if ( !play_onPhoto(photo, p, c) )
+            return false;
+        if ( !m_error )
+            ++p;
     }
 
     if ( m_error || aborted() ) {
         emitFailure();
         return false;
     }
+    if ( parallel )
+        qSort(m_outputs[0]);
     emitSuccess();
     return true;
 }
 
+bool OperatorWorker::play_onPhoto(Photo &photo, int p, int c)
+{
+    setProgress(p, c);
+    try {
+        Photo newPhoto;
+        if ( m_memoize && m_previousMemo.lookup(photo, newPhoto) ) {
+            m_memo.record(photo, newPhoto);
+            outputPush(0, newPhoto);
+            return true;
+        }
+        Photo input(photo);
+        if ( !m_operator->isCompatible(photo) ) {
+            switch ( preferences->getIncompatibleAction()) {
+            case Preferences::Warning:
+                dflWarning(tr("Incompatible pixel scale: %0").arg(photo.getIdentity()));
+                //Falls through
+            case Preferences::Ignore:
+                if ( photo.getScale() == Photo::HDR )
+                    HDR(true).applyOn(photo);
+                break;
+            default:
+            case Preferences::Error:
+                setError(photo, tr("Incompatible pixel scale"));
+                break;
+            }
+        }
+        if (!m_error) {
+            ProfileScope scope("photo", photo.getIdentity());
+            newPhoto = this->process(photo, p, c);
+            scope.setArg("operator", m_operator->getName());
+            scope.setArg("bytes", newPhoto.pixelBytes());
+            if ( !newPhoto.isComplete() ) {
+                dflDebug(tr("Photo is not complete, sending failure"));
+                m_error = true;
+                emitFailure();
+                return false;
+            }
+        }
+        if ( !m_error ) {
+            if ( m_memoize )
+                m_memo.record(input, newPhoto);
+            outputPush(0, newPhoto);
+        }
+    }
+    catch(std::exception &e) {
+        setError(photo, e.what());
+        emitFailure();
+        return false;
+    }
+    return true;
+}
+
 bool OperatorWorker::play_onInputParallel(int idx)
 {
-    int c = 0;
-    dfl_block int p = 0;
-    c = m_inputs[idx].count();
-    dfl_parallel_for(i, 0, c, 1, (), {
+    if ( m_channel )
+        return play_onChannel(true);
+
+    int p = 0;
+    play_onBatch(m_inputs[idx], p, m_inputs[idx].count());
+    if ( m_error ) {
+        dflDebug(tr("In error, sending failure"));
+        emitFailure();
+    }
+    else if ( aborted() ) {
+        dflDebug(tr("Aborted, sending failure"));
+        emitFailure();
+    }
+    else {
+        qSort(m_outputs[idx]);
+        emitSuccess();
+    }
+    return true;
+}
+
+/**
+ * @brief OperatorWorker::play_onBatch processes the photos side by side,
+ * the outputs keep the sequence numbers of their inputs whether the photos
+ * come from a channel or not
+ * @param p photos done so far, updated
+ * @param c photos expected in all
+ */
+void OperatorWorker::play_onBatch(const QVector<Photo> &photos, int &p, int c)
+{
+    dfl_block int done = p;
+    dfl_parallel_for(i, 0, photos.count(), 1, (), {
         if ( m_error || aborted() )
             continue;
         Photo photo;
 
         dfl_critical_section({
-            photo = m_inputs[idx][i];
+            photo = photos[i];
         });
         Photo newPhoto;
+        if ( m_memoize && m_previousMemo.lookup(photo, newPhoto) ) {
+            dfl_critical_section({
+                m_memo.record(photo, newPhoto);
+                setProgress(++done, c);
+                outputPush(0, newPhoto);
+            });
+            continue;
+        }
+        Photo input(photo);
         if ( !m_operator->isCompatible(photo) ) {
             switch ( preferences->getIncompatibleAction()) {
             case Preferences::Warning:
@@ -296,7 +580,10 @@ bool OperatorWorker::play_onInputParallel(int idx)
         }
         if (!m_error) {
             try {
-                newPhoto = this->process(photo, p, c);
+                ProfileScope scope("photo", photo.getIdentity());
+                newPhoto = this->process(photo, done, c);
+                scope.setArg("operator", m_operator->getName());
+                scope.setArg("bytes", newPhoto.pixelBytes());
             }
             catch (std::exception &e) {
                 setError(photo, e.what());
@@ -307,37 +594,29 @@ bool OperatorWorker::play_onInputParallel(int idx)
                 m_error = true;
                 continue;
             }
-            newPhoto.setSequenceNumber(i);
         }
         dfl_critical_section({
             if ( !m_error ) {
-                emit progress(++p, c);
-                m_outputs[0].push_back(newPhoto);
+                if ( m_memoize )
+                    m_memo.record(input, newPhoto);
+                setProgress(++done, c);
+                outputPush(0, newPhoto);
             }
         });
     });
-    if ( m_error ) {
-        dflDebug(tr("In error, sending failure"));
-        emitFailure();
-    }
-    else if ( aborted() ) {
-        dflDebug(tr("Aborted, sending failure"));
-        emitFailure();
-    }
-    else {
-        qSort(m_outputs[idx]);
-        emitSuccess();
-    }
-    return true;
+    p = done;
 }
 
 static void logMessage(Console::Level level, const QString& who, const QString& msg)
 {
-    dflMessage(level, who+"(Worker): "+msg);
+    if ( Console::isEnabled(level) )
+        dflMessage(level, who + "(Worker)", msg);
 }
 
 void OperatorWorker::dflDebug(const char *fmt, ...) const
 {
+    if ( !Console::isEnabled(Console::Debug) )
+        return;
     va_list ap;
     char *msg;
     int ret;
@@ -351,6 +630,8 @@ void OperatorWorker::dflDebug(const char *fmt, ...) const
 
 void OperatorWorker::dflInfo(const char *fmt, ...) const
 {
+    if ( !Console::isEnabled(Console::Info) )
+        return;
     va_list ap;
     char *msg;
     int ret;
@@ -364,6 +645,8 @@ void OperatorWorker::dflInfo(const char *fmt, ...) const
 
 void OperatorWorker::dflWarning(const char *fmt, ...) const
 {
+    if ( !Console::isEnabled(Console::Warning) )
+        return;
     va_list ap;
     char *msg;
     int ret;
@@ -377,6 +660,8 @@ void OperatorWorker::dflWarning(const char *fmt, ...) const
 
 void OperatorWorker::dflError(const char *fmt, ...) const
 {
+    if ( !Console::isEnabled(Console::Error) )
+        return;
     va_list ap;
     char *msg;
     int ret;
@@ -390,6 +675,8 @@ void OperatorWorker::dflError(const char *fmt, ...) const
 
 void OperatorWorker::dflCritical(const char *fmt, ...) const
 {
+    if ( !Console::isEnabled(Console::Critical) )
+        return;
     va_list ap;
     char *msg;
     int ret;
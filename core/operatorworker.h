@@ -34,12 +34,18 @@
 #include <QObject>
 #include <QVector>
 #include <QElapsedTimer>
+#include <QMap>
+#include <QByteArray>
+#include <memory>
 
 #include "ports.h"
 #include "photo.h"
 #include "operator.h"
+#include "photomemo.h"
+#include "progresscounter.h"
 
 class QThread;
+class PhotoChannel;
 
 
 class OperatorWorker : public QObject
@@ -49,13 +55,69 @@ public:
     explicit OperatorWorker(QThread *thread, Operator* op);
 
     void start(QVector<QVector<Photo> > inputs, QVector<Operator::OperatorOutputStatus> outputStatus);
+    void start(std::shared_ptr<PhotoChannel> channel,
+               const QMap<QString, QMap<QString, QString> >& tagsOverride,
+               QVector<Operator::OperatorOutputStatus> outputStatus);
 
     int outputsCount();
+    /**
+     * @brief outputEnabled
+     * @return false if the photos pushed on that output are dropped
+     */
+    bool outputEnabled(int idx) const;
     void outputPush(int idx, const Photo& photo);
     void outputSort(int idx);
 
     bool aborted();
 
+    /**
+     * @brief setCacheKey
+     * @param key the results are stored in the result cache under that key
+     * on success, if they took long enough to compute
+     */
+    void setCacheKey(const QByteArray& key);
+
+    /**
+     * @brief setSchedulingHints
+     * @param priority critical path length, longer runs first
+     * @param footprint estimated memory used while running, in bytes
+     */
+    void setSchedulingHints(int priority, qint64 footprint);
+
+    /**
+     * @brief setPhotoMemo enables the reuse of previous results, photo by
+     * photo, for operators whose outputs only depend on one input photo
+     * @param memo what the previous run produced
+     */
+    void setPhotoMemo(const PhotoMemo& memo);
+    /**
+     * @brief photoMemo
+     * @return what this run produced, to be given to the next one
+     */
+    PhotoMemo photoMemo() const;
+
+    /**
+     * @brief progressCounter
+     * @return the counter updated by the worker threads, sampled by the operator
+     */
+    std::shared_ptr<ProgressCounter> progressCounter() const;
+
+    /**
+     * @brief acquireSlot waits until the scheduler lets the worker run
+     * @param footprint estimated memory used while running, in bytes
+     * @return false if the worker was aborted while waiting
+     */
+    bool acquireSlot(qint64 footprint);
+    /**
+     * @brief acquireSlot acquires again the slot given back by releaseSlot()
+     */
+    bool acquireSlot();
+    /**
+     * @brief releaseSlot gives the slot back while the worker is blocked
+     * @return false if the worker held no slot
+     */
+    bool releaseSlot();
+
     virtual void play();
 protected slots:
     void started();
@@ -63,7 +125,6 @@ protected slots:
     void finished();
 
 signals:
-    void progress(int ,int);
     void doStart();
     void success(QVector<QVector<Photo> >);
     void failure();
@@ -75,7 +136,19 @@ protected:
 private:
     QVector<QVector<Photo> > m_outputs;
     QVector<Operator::OperatorOutputStatus> m_outputStatus;
+    QVector<QVector<std::shared_ptr<PhotoChannel> > > m_channels;
+    std::shared_ptr<PhotoChannel> m_channel;
+    QMap<QString, QMap<QString, QString> > m_tagsOverride;
     QElapsedTimer m_elapsed;
+    bool m_workerAcquired;
+    qint64 m_slotFootprint;
+    QByteArray m_cacheKey;
+    int m_priority;
+    qint64 m_footprint;
+    bool m_memoize;
+    PhotoMemo m_previousMemo;
+    PhotoMemo m_memo;
+    std::shared_ptr<ProgressCounter> m_progress;
 protected:
     bool m_signalEmited;
     mutable bool m_error;
@@ -84,11 +157,16 @@ protected:
     void emitFailure();
     void emitSuccess();
     void emitProgress(int p, int c, int sub_p, int sub_c);
+    void setProgress(int p, int c);
+    void advanceProgress(int steps = 1);
     bool play_inputsAvailable();
     bool play_outputsAvailable();
     virtual void play_analyseSources();
     virtual bool play_onInput(int idx);
     virtual bool play_onInputParallel(int idx);
+    bool play_onChannel(bool parallel);
+    void play_onBatch(const QVector<Photo>& photos, int& p, int c);
+    bool play_onPhoto(Photo &photo, int p, int c);
 
 public:
     void dflDebug(const char* fmt, ...) const DF_PRINTF_FORMAT(2,3);
@@ -106,6 +184,7 @@ public:
 
 private:
     void prepareOutputs(QVector<Operator::OperatorOutputStatus> outputStatus);
+    void closeChannels(bool success);
 };
 
 #endif // OPERATORWORKER_H
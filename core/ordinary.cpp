@@ -33,10 +33,29 @@
 
 #if !defined(_OPENMP) || defined(DF_WINDOWS)
 
+#include <atomic>
+
+/* views most recently used by the thread, looked up without locking */
+#define DF_VIEW_SLOTS 16
+
+namespace {
+struct ViewSlot {
+    quint64 serial;
+    Magick::Pixels *view;
+};
+DF_THREAD_LOCAL ViewSlot t_slots[DF_VIEW_SLOTS];
+DF_THREAD_LOCAL unsigned t_nextSlot;
+/* serials are never reused, a slot left by a deleted object cannot match */
+std::atomic<quint64> s_serial(0);
+}
+
 Ordinary::Pixels::Pixels(Magick::Image &image) :
     m_image(&image),
     m_pixels(),
-    m_mutex()
+    m_mutex(),
+    m_onDisk(MagickCore::GetImagePixelCacheType(image.image()) == MagickCore::DiskCache),
+    m_transfer(),
+    m_serial(++s_serial)
 {
 }
 
@@ -44,40 +63,118 @@ Ordinary::Pixels::~Pixels()
 {
 }
 
-Magick::PixelPacket *Ordinary::Pixels::get(const ssize_t x_, const ssize_t y_, const size_t columns_, const size_t rows_)
+Magick::Pixels *Ordinary::Pixels::view(bool create)
+{
+    for ( int i = 0 ; i < DF_VIEW_SLOTS ; ++i )
+        if ( t_slots[i].serial == m_serial )
+            return t_slots[i].view;
+    return lookup(create);
+}
+
+Magick::Pixels *Ordinary::Pixels::lookup(bool create)
 {
     pthread_t self = pthread_self();
-    m_mutex.lock();
+    QMutexLocker lock(&m_mutex);
     std::shared_ptr<Magick::Pixels>& pixels = m_pixels[self];
-    m_mutex.unlock();
     if (!pixels) {
+        if (!create)
+            return NULL;
         pixels.reset(new Magick::Pixels(*m_image));
     }
+    ViewSlot& slot = t_slots[t_nextSlot++ % DF_VIEW_SLOTS];
+    slot.serial = m_serial;
+    slot.view = pixels.get();
+    return pixels.get();
+}
+
+Magick::PixelPacket *Ordinary::Pixels::get(const ssize_t x_, const ssize_t y_, const size_t columns_, const size_t rows_)
+{
+    Magick::Pixels *pixels = view(true);
+    if ( m_onDisk ) {
+        QMutexLocker lock(&m_transfer);
+        return pixels->get(x_, y_, columns_, rows_);
+    }
     return pixels->get(x_, y_, columns_, rows_);
 }
 
 const Magick::PixelPacket *Ordinary::Pixels::getConst(const ssize_t x_, const ssize_t y_, const size_t columns_, const size_t rows_)
 {
-    pthread_t self = pthread_self();
-    m_mutex.lock();
-    std::shared_ptr<Magick::Pixels>& pixels = m_pixels[self];
-    m_mutex.unlock();
-    if (!pixels) {
-        pixels.reset(new Magick::Pixels(*m_image));
+    Magick::Pixels *pixels = view(true);
+    if ( m_onDisk ) {
+        QMutexLocker lock(&m_transfer);
+        return pixels->getConst(x_, y_, columns_, rows_);
     }
     return pixels->getConst(x_, y_, columns_, rows_);
 }
 
 void Ordinary::Pixels::sync()
 {
-    pthread_t self = pthread_self();
-    m_mutex.lock();
-    std::shared_ptr<Magick::Pixels>& pixels = m_pixels[self];
-    m_mutex.unlock();
+    Magick::Pixels *pixels = view(false);
     if (pixels) {
-        pixels->sync();
-        //pixels.reset();
+        if ( m_onDisk ) {
+            QMutexLocker lock(&m_transfer);
+            pixels->sync();
+        }
+        else {
+            pixels->sync();
+        }
     }
 }
 
 #endif
+
+FramePixels::FramePixels(Magick::Image &image, bool writable) :
+    m_image(image),
+    m_writable(writable),
+    m_columns(image.columns()),
+    m_direct(NULL),
+    m_cache()
+{
+    MagickCore::CacheType type = MagickCore::GetImagePixelCacheType(image.image());
+    if ( type == MagickCore::MemoryCache || type == MagickCore::MapCache ) {
+        if ( writable )
+            m_direct = image.getPixels(0, 0, image.columns(), image.rows());
+        else
+            m_direct = const_cast<Magick::PixelPacket*>(
+                        image.getConstPixels(0, 0, image.columns(), image.rows()));
+    }
+    if ( !m_direct )
+        m_cache.reset(new Ordinary::Pixels(image));
+}
+
+FramePixels::~FramePixels()
+{
+    if ( m_direct && m_writable )
+        m_image.syncPixels();
+}
+
+Magick::PixelPacket *FramePixels::get(ssize_t y, size_t rows)
+{
+    Q_ASSERT(m_writable);
+    if ( m_direct )
+        return m_direct + y * m_columns;
+#if defined(_OPENMP) && !defined(DF_WINDOWS)
+    QMutexLocker lock(&m_transfer);
+#endif
+    return m_cache->get(0, y, m_columns, rows);
+}
+
+const Magick::PixelPacket *FramePixels::getConst(ssize_t y, size_t rows)
+{
+    if ( m_direct )
+        return m_direct + y * m_columns;
+#if defined(_OPENMP) && !defined(DF_WINDOWS)
+    QMutexLocker lock(&m_transfer);
+#endif
+    return m_cache->getConst(0, y, m_columns, rows);
+}
+
+void FramePixels::sync()
+{
+    if ( m_direct )
+        return;
+#if defined(_OPENMP) && !defined(DF_WINDOWS)
+    QMutexLocker lock(&m_transfer);
+#endif
+    m_cache->sync();
+}
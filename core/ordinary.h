@@ -56,11 +56,20 @@
  */
 namespace Ordinary {
 
+/*
+ * Each thread gets its own view. Views of a memory or mapped cache
+ * point straight at the pixels; views of a disk cache are copies
+ * read and written back by ImageMagick, these transfers are serialized
+ * so the threads can still work on their own rows concurrently.
+ */
 class Pixels
 {
     Magick::Image *m_image;
     QMap<pthread_t, std::shared_ptr<Magick::Pixels > > m_pixels;
     QMutex m_mutex;
+    bool m_onDisk;
+    QMutex m_transfer;
+    quint64 m_serial;
 public:
     Pixels(Magick::Image& image);
     ~Pixels(void);
@@ -72,7 +81,54 @@ public:
 
 private:
     Pixels(const Pixels&);
+    Magick::Pixels *view(bool create);
+    Magick::Pixels *lookup(bool create);
 };
 }
 #endif
+
+#include <Magick++.h>
+#include <QMutex>
+#include <memory>
+
+/**
+ * @brief The FramePixels class hands out rows of a whole frame
+ *
+ * When the pixel cache is in memory or memory-mapped, the frame is
+ * fetched once and every row is a plain pointer into it, shared by all
+ * the threads. Otherwise it falls back on per-thread views.
+ */
+class FramePixels
+{
+public:
+    /**
+     * @brief FramePixels
+     * @param writable rows are written, the image must not be shared
+     */
+    FramePixels(Magick::Image& image, bool writable);
+    ~FramePixels();
+
+    bool isDirect() const { return m_direct != NULL; }
+    Magick::PixelPacket *get(ssize_t y, size_t rows);
+    const Magick::PixelPacket *getConst(ssize_t y, size_t rows);
+    /**
+     * @brief sync writes the rows of the calling thread back, only needed
+     * when the frame is not direct
+     */
+    void sync();
+
+private:
+    FramePixels(const FramePixels&);
+    Magick::Image& m_image;
+    bool m_writable;
+    size_t m_columns;
+    Magick::PixelPacket *m_direct;
+    std::shared_ptr<Ordinary::Pixels> m_cache;
+#if defined(_OPENMP) && !defined(DF_WINDOWS)
+    /* Ordinary is Magick there, the disk cache transfers are
+     * serialized here rather than in Ordinary::Pixels */
+    QMutex m_transfer;
+#endif
+};
+
 #endif // PIXELS_H
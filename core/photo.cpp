@@ -34,11 +34,14 @@
 #include <QPixmap>
 #include <QElapsedTimer>
 #include <QRectF>
+#include <QMutex>
+#include <QMutexLocker>
 #include <Magick++.h>
 #include <cmath>
 
 #include <string>
 #include <cstdio>
+#include <atomic>
 
 #include "ports.h"
 #include "igamma.h"
@@ -50,14 +53,49 @@
 
 using Magick::Quantum;
 
+/**
+ * @brief The Photo::Encoding class encodes a planar buffer in an image once
+ * for all the copies of a photo, whichever thread asks for it first
+ */
+class Photo::Encoding
+{
+public:
+    explicit Encoding(std::shared_ptr<const PlanarBuffer> planar) :
+        m_planar(planar),
+        m_mutex()
+    {
+        m_encoded[0] = m_encoded[1] = false;
+    }
+
+    const Magick::Image& image(bool hdr)
+    {
+        QMutexLocker lock(&m_mutex);
+        if ( !m_encoded[hdr] ) {
+            m_planar->toImage(m_images[hdr], hdr);
+            m_encoded[hdr] = true;
+        }
+        return m_images[hdr];
+    }
+
+private:
+    Q_DISABLE_COPY(Encoding)
+    std::shared_ptr<const PlanarBuffer> m_planar;
+    QMutex m_mutex;
+    bool m_encoded[2];
+    Magick::Image m_images[2];
+};
+
 Photo::Photo(Photo::Gamma gamma, QObject *parent) :
     QObject(parent),
     m_image(),
+    m_planar(),
+    m_encoding(),
     m_curve(newCurve(gamma)),
     m_status(Photo::Undefined),
     m_tags(),
     m_identity(Process::uuid()),
-    m_sequenceNumber(0)
+    m_sequenceNumber(0),
+    m_generation(newGeneration())
 {
     setScale(gamma);
 }
@@ -65,11 +103,14 @@ Photo::Photo(Photo::Gamma gamma, QObject *parent) :
 Photo::Photo(const Magick::Blob &blob, Photo::Gamma gamma, QObject *parent) :
     QObject(parent),
     m_image(blob),
+    m_planar(),
+    m_encoding(),
     m_curve(newCurve(gamma)),
     m_status(Photo::Complete),
     m_tags(),
     m_identity(Process::uuid()),
-    m_sequenceNumber(0)
+    m_sequenceNumber(0),
+    m_generation(newGeneration())
 {
     setScale(gamma);
 }
@@ -77,11 +118,14 @@ Photo::Photo(const Magick::Blob &blob, Photo::Gamma gamma, QObject *parent) :
 Photo::Photo(const Magick::Image& image, Photo::Gamma gamma, QObject *parent) :
     QObject(parent),
     m_image(image),
+    m_planar(),
+    m_encoding(),
     m_curve(newCurve(gamma)),
     m_status(Photo::Complete),
     m_tags(),
     m_identity(Process::uuid()),
-    m_sequenceNumber(0)
+    m_sequenceNumber(0),
+    m_generation(newGeneration())
 {
     setScale(gamma);
 }
@@ -89,11 +133,14 @@ Photo::Photo(const Magick::Image& image, Photo::Gamma gamma, QObject *parent) :
 Photo::Photo(const Photo &photo) :
     QObject(photo.parent()),
     m_image(photo.m_image),
+    m_planar(photo.m_planar),
+    m_encoding(photo.m_encoding),
     m_curve(photo.m_curve),
     m_status(photo.m_status),
     m_tags(photo.m_tags),
     m_identity(photo.m_identity),
-    m_sequenceNumber(photo.m_sequenceNumber)
+    m_sequenceNumber(photo.m_sequenceNumber),
+    m_generation(photo.m_generation)
 {
 }
 
@@ -104,11 +151,14 @@ Photo::~Photo()
 Photo &Photo::operator=(const Photo &photo)
 {
     m_image = photo.m_image;
+    m_planar = photo.m_planar;
+    m_encoding = photo.m_encoding;
     m_curve = photo.m_curve;
     m_tags = photo.m_tags;
     m_identity = photo.m_identity;
     m_sequenceNumber = photo.m_sequenceNumber;
     m_status = photo.m_status;
+    m_generation = photo.m_generation;
     return *this;
 }
 
@@ -121,6 +171,8 @@ bool Photo::load(const QString &filename)
     try {
         Magick::Blob blob(data.data(), data.length());
         m_image = Magick::Image(blob);
+        resetPlanar();
+        m_generation = newGeneration();
         m_status = Photo::Complete;
     }
     catch (std::exception& e) {
@@ -138,6 +190,7 @@ bool Photo::save(const QString &filename, const QString &magick)
 {
     try {
         Magick::Blob blob;
+        materialize();
         m_image.write(&blob, magick.toStdString());
         QFile file(filename);
         file.open(QFile::WriteOnly);
@@ -159,6 +212,8 @@ void Photo::createImage(long width, long height)
     try {
         m_image = Magick::Image(Magick::Geometry(width,height),Magick::Color(0,0,0));
         m_image.quantizeColorSpace(Magick::RGBColorspace);
+        resetPlanar();
+        m_generation = newGeneration();
         m_status = Complete;
     }
     catch (std::exception &e) {
@@ -169,12 +224,14 @@ void Photo::createImage(long width, long height)
 
 void Photo::createImageAlike(const Photo& photo)
 {
-    createImage(photo.m_image.columns(), photo.m_image.rows());
+    const Magick::Image& image = photo.image();
+    createImage(image.columns(), image.rows());
 }
 
 QVector<qreal> Photo::pixelColor(unsigned x, unsigned y)
 {
     QVector<qreal> rgb(3);
+    materialize();
     if ( x >= m_image.columns() ||
          y >= m_image.rows() )
         return rgb;
@@ -203,22 +260,94 @@ QVector<qreal> Photo::pixelColor(unsigned x, unsigned y)
 
 const Magick::Image& Photo::image() const
 {
+    if ( m_encoding )
+        return m_encoding->image(getScale() == HDR);
     return m_image;
 }
 
 Magick::Image& Photo::image()
 {
+    materialize();
+    // the caller may write the pixels
+    m_planar.reset();
+    m_generation = newGeneration();
     return m_image;
 }
 
 const Magick::Image &Photo::curve() const
 {
-    return m_curve;
+    return m_curve.image();
 }
 
 Magick::Image &Photo::curve()
 {
-    return m_curve;
+    m_generation = newGeneration();
+    return m_curve.image();
+}
+
+void Photo::composeCurve(std::shared_ptr<const quantum_t> lut)
+{
+    m_curve.compose(lut);
+    m_generation = newGeneration();
+}
+
+bool Photo::sharesCurveWith(const Photo &photo) const
+{
+    return m_curve.isSharedWith(photo.m_curve);
+}
+
+std::shared_ptr<const PlanarBuffer> Photo::planar() const
+{
+    if ( !m_planar )
+        m_planar = PlanarBuffer::fromImage(m_image, getScale() == HDR);
+    return m_planar;
+}
+
+void Photo::setPlanar(std::shared_ptr<const PlanarBuffer> buffer)
+{
+    m_planar = buffer;
+    m_encoding.reset(new Encoding(buffer));
+    m_generation = newGeneration();
+    m_status = Complete;
+}
+
+qint64 Photo::pixelBytes() const
+{
+    if ( m_encoding )
+        return qint64(m_planar->stride()) * m_planar->height() *
+                PlanarBuffer::PlaneCount * sizeof(float);
+    return qint64(m_image.columns()) * m_image.rows() * sizeof(Magick::PixelPacket);
+}
+
+quint64 Photo::generation() const
+{
+    return m_generation;
+}
+
+quint64 Photo::newGeneration()
+{
+    /* serials are never reused, unlike the addresses of freed images */
+    static std::atomic<quint64> generation(0);
+    return ++generation;
+}
+
+bool Photo::isPlanar() const
+{
+    return m_encoding != NULL;
+}
+
+void Photo::materialize()
+{
+    if ( !m_encoding )
+        return;
+    m_image = m_encoding->image(getScale() == HDR);
+    m_encoding.reset();
+}
+
+void Photo::resetPlanar()
+{
+    m_planar.reset();
+    m_encoding.reset();
 }
 
 QMap<QString, QString> Photo::tags() const
@@ -245,8 +374,17 @@ QString Photo::getTag(const QString &name) const
 }
 
 
-Magick::Image Photo::newCurve(Photo::Gamma gamma)
+ToneCurve Photo::newCurve(Photo::Gamma gamma)
 {
+    /* every photo of a given scale starts from the same curve. The curves
+     * are never freed, ImageMagick may be terminated before the static
+     * destructors would run */
+    static QMutex mutex;
+    static QMap<int, Magick::Image> *curves = new QMap<int, Magick::Image>;
+    QMutexLocker lock(&mutex);
+    QMap<int, Magick::Image>::const_iterator it = curves->find(gamma);
+    if ( it != curves->end() )
+        return ToneCurve(it.value());
     Magick::Image curve(Magick::Geometry(65536, 1), Magick::Color(0, 0, 0));
     Ordinary::Pixels curve_cache(curve);
     Magick::PixelPacket *pixels = curve_cache.get(0,0,65536,1);
@@ -274,7 +412,8 @@ Magick::Image Photo::newCurve(Photo::Gamma gamma)
         iGamma::sRGB().applyOnImage(curve, false);
         break;
     }
-    return curve;
+    curves->insert(gamma, curve);
+    return ToneCurve(curve);
 }
 
 static QPixmap convert(Magick::Image& image) {
@@ -661,7 +800,7 @@ QPixmap Photo::histogramToPixmap(Photo::HistogramScale scale, Photo::HistogramGe
 
 void Photo::writeJPG(const QString &filename)
 {
-    Magick::Image image(m_image);
+    Magick::Image image(this->image());
     image.magick("JPG");
     Magick::Blob blob;
     image.write(&blob);
@@ -734,6 +873,8 @@ void Photo::setUndefined()
 {
     m_status = Undefined;
     m_image = Magick::Image();
+    resetPlanar();
+    m_generation = newGeneration();
 }
 
 void Photo::setComplete()
@@ -828,6 +969,9 @@ void Photo::setROI(const QRectF &rect)
 
 void Photo::setScale(Photo::Gamma gamma)
 {
+    // a planar buffer decoded with the previous scale no longer matches
+    if ( !m_encoding )
+        m_planar.reset();
     if ( gamma & Linear ) {
         setTag(TAG_SCALE, TAG_SCALE_LINEAR);
     } else if ( gamma & NonLinear ) {
@@ -934,10 +1078,16 @@ bool OnDiskCache()
 
 bool OnDiskCache(const Magick::Image &image)
 {
+#if defined(_OPENMP) && !defined(DF_WINDOWS)
     bool onDisk = MagickCore::GetImagePixelCacheType(const_cast<Magick::Image&>(image).image()) == MagickCore::DiskCache;
     if (onDisk)
         dflDebug(Photo::tr("Image cache is on disk, threading disabled"));
     return onDisk;
+#else
+    /* Ordinary::Pixels serializes the disk cache transfers */
+    Q_UNUSED(image);
+    return false;
+#endif
 }
 
 bool OnDiskCache(const Magick::Image &image1, const Magick::Image &image2)
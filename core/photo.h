@@ -39,6 +39,11 @@
 
 #include "ports.h"
 #include "preferences.h"
+#include "planarbuffer.h"
+#include "tonecurve.h"
+#include "threadbudget.h"
+#include "cancellation.h"
+#include "profiler.h"
 
 //#define DEBUG_DISABLE_OPENMP
 
@@ -65,6 +70,15 @@ Q_STATIC_ASSERT(MAGICKCORE_QUANTUM_DEPTH == 16);
 typedef int quantum_t;
 
 void ResetImage(Magick::Image &image);
+/*
+ * __image_list__ names the images a dfl_parallel_for body reads or writes
+ * through Ordinary::Pixels. Outside of OpenMP or on Windows, Ordinary::Pixels
+ * serializes the transfers of disk caches and the loop keeps its threads.
+ * Elsewhere Ordinary is Magick, whose views of a disk cache are not safe to
+ * share, and the loop runs on one thread if one of the images is on disk.
+ * Loops going through FramePixels, which serializes them in every build,
+ * pass no image.
+ */
 bool OnDiskCache();
 bool OnDiskCache(const Magick::Image& image);
 bool OnDiskCache(const Magick::Image& image1, const Magick::Image& image2);
@@ -73,11 +87,29 @@ bool OnDiskCache(const Magick::Image& image1, const Magick::Image& image2, const
 bool OnDiskCache(const Magick::Image& image1, const Magick::Image& image2, const Magick::Image& image3, const Magick::Image& image4, const Magick::Image& image5);
 bool OnDiskCache(const Magick::Image& image1, const Magick::Image& image2, const Magick::Image& image3, const Magick::Image& image4, const Magick::Image& image5, const Magick::Image& image6);
 int DfThreadLimit();
+/**
+ * @brief DfSectionThreads
+ * @return the threads worth reserving for a loop, no more than its chunks
+ */
+static inline int DfSectionThreads(long long start, long long end, long long stride)
+{
+    return int(qMin<long long>(DfThreadLimit(), (end - start + stride - 1) / stride));
+}
 
 class AtWork {
+    ProfileRegion *m_region;
+    qint64 m_start;
 public:
-    AtWork() { preferences->incrAtWork(); }
-    ~AtWork() { preferences->decrAtWork(); }
+    AtWork() : m_region(NULL), m_start(0) { preferences->incrAtWork(); }
+    explicit AtWork(ProfileRegion *region) : m_region(region), m_start(0) {
+        preferences->incrAtWork();
+        m_start = m_region->begin();
+    }
+    ~AtWork() {
+        if ( m_region )
+            m_region->end(m_start);
+        preferences->decrAtWork();
+    }
 };
 
 
@@ -140,18 +172,27 @@ do \
     size_t _dfl_end = __end__; \
     size_t _dfl_stride = __stride__; \
     size_t _dfl_n_strides = (_dfl_end-_dfl_start)/_dfl_stride; \
-    int _dfl_num_threads = (OnDiskCache __image_list__)?1:DfThreadLimit(); \
+    DfThreads _dfl_threads((OnDiskCache __image_list__)?1:DfSectionThreads(_dfl_start, _dfl_end, _dfl_stride)); \
+    int _dfl_num_threads = _dfl_threads.count(); \
+    int _dfl_share = _dfl_threads.share(); \
+    QThread *_dfl_cancel = DfCancellation::current(); \
+    ProfileRegion _dfl_region(__FILE__, __LINE__, _dfl_num_threads); \
+    ProfileRegion *_dfl_region_p = &_dfl_region; \
     std::shared_ptr<DflDispatch> _dfl_dispatch(new DflDispatch(_dfl_num_threads)); \
     if (_dfl_num_threads > 1 ) { \
         dispatch_apply(_dfl_n_strides, \
                    _dfl_dispatch->queue(), \
                    ^(size_t _dfl_idx) { \
-                       AtWork atWork; \
                        Acquire sem(_dfl_dispatch); \
+                       AtWork atWork(_dfl_region_p); \
                        size_t i_start = _dfl_idx * _dfl_stride + _dfl_start; \
                        size_t i_end = i_start + _dfl_stride; \
+                       DfCancellation _dfl_scope(_dfl_cancel); \
+                       DfSectionMember _dfl_member(_dfl_share); \
                        for ( int __var__ = i_start ; __var__ < (int)i_end ; ++__var__) \
                        { \
+                        if ( DfCancellation::requested(_dfl_cancel) ) \
+                            break; \
                         __VA_ARGS__ \
                        } \
                    }); \
@@ -159,7 +200,10 @@ do \
         _dfl_n_strides = _dfl_stride = 0; \
     } \
     for ( int __var__ = _dfl_n_strides*_dfl_stride + _dfl_start ; __var__ < (int)_dfl_end ; ++__var__) \
-        { AtWork atWork; \
+        { AtWork atWork(_dfl_region_p); \
+            DfSectionMember _dfl_member(_dfl_share); \
+            if ( DfCancellation::requested(_dfl_cancel) ) \
+                break; \
             { __VA_ARGS__ } \
         } \
 } while (0)
@@ -173,7 +217,6 @@ do \
 #define dfl_block_array(type, name, size) type name[size] = {}
 #define dfl_block volatile
 #define dfl_threads(chunk, ...) schedule(static, chunk) num_threads(OnDiskCache(__VA_ARGS__)?1:DfThreadLimit())
-//"num_threads(OnDiskCache " STRINGIFY(__image_list__) " ?1:DfThreadLimit())"
 #if defined(DF_WINDOWS)
 #define DF_PRAGMA(pragma_string) __pragma(pragma_string)
 #else
@@ -182,8 +225,9 @@ do \
 #ifdef DEBUG_DISABLE_OPENMP
 # define dfl_parallel_for(__var__, __start__, __end__, __stride__, __image_list__, ...) \
 do {\
+    ProfileRegion _dfl_region(__FILE__, __LINE__, 1); \
     for(int __var__ = __start__ ; __var__ < __end__ ; ++__var__ ) \
-        { AtWork atWork; { __VA_ARGS__ } }\
+        { AtWork atWork(&_dfl_region); if ( DfCancellation::requested() ) break; { __VA_ARGS__ } }\
 } while (0)
 
 # define dfl_critical_section(...) do { __VA_ARGS__ } while (0)
@@ -191,9 +235,14 @@ do {\
 #else
 # define dfl_parallel_for(__var__, __start__, __end__, __stride__, __image_list__, ...) \
 do {\
-    DF_PRAGMA(omp parallel for schedule(static, __stride__) num_threads((OnDiskCache __image_list__ )?1:DfThreadLimit())) \
+    DfThreads _dfl_threads((OnDiskCache __image_list__)?1:DfSectionThreads(__start__, __end__, __stride__)); \
+    QThread *_dfl_cancel = DfCancellation::current(); \
+    ProfileRegion _dfl_region(__FILE__, __LINE__, _dfl_threads.count()); \
+    DF_PRAGMA(omp parallel for schedule(static, __stride__) num_threads(_dfl_threads.count())) \
     for(int __var__ = __start__ ; __var__ < __end__ ; ++__var__ ) \
-        { AtWork atWork; { __VA_ARGS__ } }\
+        { if ( DfCancellation::requested(_dfl_cancel) ) continue; \
+          DfCancellation _dfl_scope(_dfl_cancel); DfSectionMember _dfl_member(_dfl_threads.share()); \
+          AtWork atWork(&_dfl_region); { __VA_ARGS__ } }\
 } while (0)
 
 # define dfl_critical_section(...) DF_PRAGMA(omp critical) { __VA_ARGS__ }
@@ -294,6 +343,38 @@ public:
     Magick::Image& image();
     const Magick::Image &curve() const;
     Magick::Image &curve();
+    /**
+     * @brief composeCurve applies lut on the curve, lazily
+     */
+    void composeCurve(std::shared_ptr<const quantum_t> lut);
+    bool sharesCurveWith(const Photo& photo) const;
+    /**
+     * @brief planar
+     * @return the pixels as linear float planes, whatever the scale
+     */
+    std::shared_ptr<const PlanarBuffer> planar() const;
+    /**
+     * @brief setPlanar replaces the pixels, the image is only
+     * encoded again when it is asked for
+     */
+    void setPlanar(std::shared_ptr<const PlanarBuffer> buffer);
+    /**
+     * @brief pixelBytes
+     * @return the memory held by the pixels, without encoding them
+     */
+    qint64 pixelBytes() const;
+    /**
+     * @brief isPlanar
+     * @return true if the planar buffer holds the pixels, the image is
+     * only encoded when asked for
+     */
+    bool isPlanar() const;
+    /**
+     * @brief generation
+     * @return a serial shared by the copies of the photo, renewed whenever
+     * its pixels or its curve may be written
+     */
+    quint64 generation() const;
 
     QMap<QString, QString> tags() const;
     void setTag(const QString& name, const QString& value);
@@ -329,15 +410,24 @@ public:
     static Photo *findReference(Photo **photos, int count);
 
 private:
+    class Encoding;
     Magick::Image m_image;
-    Magick::Image m_curve;
+    mutable std::shared_ptr<const PlanarBuffer> m_planar;
+    /* set while m_image is stale, shared by the copies of the photo */
+    std::shared_ptr<Encoding> m_encoding;
+    ToneCurve m_curve;
     Status m_status;
     QMap<QString, QString> m_tags;
     QString m_identity;
     int m_sequenceNumber;
+    quint64 m_generation;
+
 
+    void materialize();
+    void resetPlanar();
 
-    static Magick::Image newCurve(Gamma gamma);
+    static ToneCurve newCurve(Gamma gamma);
+    static quint64 newGeneration();
 };
 
 #define TAG_NAME "Name"
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#include <QMutexLocker>
+
+#include "photochannel.h"
+#include "operatorworker.h"
+
+PhotoChannel::PhotoChannel(Operator *consumer, int capacity) :
+    m_consumer(consumer),
+    m_capacity(capacity),
+    m_expected(0),
+    m_attached(false),
+    m_detached(false),
+    m_closed(false),
+    m_success(false),
+    m_queue(),
+    m_mutex(),
+    m_notEmpty(),
+    m_notFull()
+{
+}
+
+Operator *PhotoChannel::consumer() const
+{
+    return m_consumer;
+}
+
+void PhotoChannel::attach()
+{
+    QMutexLocker lock(&m_mutex);
+    m_attached = true;
+}
+
+void PhotoChannel::detach()
+{
+    QMutexLocker lock(&m_mutex);
+    m_attached = false;
+    m_detached = true;
+    m_queue.clear();
+    m_notFull.wakeAll();
+}
+
+void PhotoChannel::setExpected(int expected)
+{
+    QMutexLocker lock(&m_mutex);
+    m_expected = expected;
+}
+
+int PhotoChannel::expected()
+{
+    QMutexLocker lock(&m_mutex);
+    return m_expected;
+}
+
+void PhotoChannel::push(const Photo &photo, OperatorWorker *producer)
+{
+    bool released = false;
+    {
+        QMutexLocker lock(&m_mutex);
+        /* the photos are also held by the producer outputs, the queue only
+         * costs references, back pressure is only applied while someone
+         * is actually consuming */
+        while ( m_attached &&
+                m_queue.count() >= m_capacity &&
+                !producer->aborted() ) {
+            /* the consumer needs a slot to drain the queue */
+            if ( !released )
+                released = producer->releaseSlot();
+            m_notFull.wait(&m_mutex, 50);
+        }
+        if ( !m_closed && !m_detached ) {
+            m_queue.enqueue(photo);
+            m_notEmpty.wakeAll();
+        }
+    }
+    /* an aborted producer fails on its own */
+    if ( released )
+        producer->acquireSlot();
+}
+
+void PhotoChannel::close(bool success)
+{
+    QMutexLocker lock(&m_mutex);
+    if ( m_closed )
+        return;
+    m_closed = true;
+    m_success = success;
+    m_notEmpty.wakeAll();
+}
+
+PhotoChannel::Status PhotoChannel::pop(Photo &photo, unsigned long timeout)
+{
+    QMutexLocker lock(&m_mutex);
+    if ( m_queue.isEmpty() && !m_closed )
+        m_notEmpty.wait(&m_mutex, timeout);
+    if ( !m_queue.isEmpty() ) {
+        photo = m_queue.dequeue();
+        m_notFull.wakeAll();
+        return Popped;
+    }
+    if ( m_closed )
+        return m_success ? Closed : Failed;
+    return Timeout;
+}
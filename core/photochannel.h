@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#ifndef PHOTOCHANNEL_H
+#define PHOTOCHANNEL_H
+
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "photo.h"
+
+/* number of photos a producer may be ahead of a pipelined consumer */
+#define DF_PIPELINE_DEPTH 4
+
+class Operator;
+class OperatorWorker;
+
+/**
+ * @brief The PhotoChannel class hands photos one by one from the worker of
+ * an upstream operator to the worker of a downstream pipelined operator.
+ *
+ * The producer blocks when more than capacity photos are pending and the
+ * consumer is attached, so that a fast producer can't run away. Meanwhile
+ * it gives its scheduler slot back, the consumer needs one to drain the
+ * queue.
+ */
+class PhotoChannel
+{
+public:
+    typedef enum {
+        Popped,
+        Timeout,
+        Closed,
+        Failed
+    } Status;
+
+    PhotoChannel(Operator *consumer, int capacity);
+
+    Operator *consumer() const;
+
+    void attach();
+    void detach();
+
+    void setExpected(int expected);
+    int expected();
+
+    void push(const Photo& photo, OperatorWorker *producer);
+    void close(bool success);
+    Status pop(Photo& photo, unsigned long timeout);
+
+private:
+    Q_DISABLE_COPY(PhotoChannel)
+    Operator *m_consumer;
+    int m_capacity;
+    int m_expected;
+    bool m_attached;
+    bool m_detached;
+    bool m_closed;
+    bool m_success;
+    QQueue<Photo> m_queue;
+    QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+};
+
+#endif // PHOTOCHANNEL_H
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#include "photomemo.h"
+
+PhotoMemo::PhotoMemo() :
+    m_entries()
+{
+}
+
+bool PhotoMemo::lookup(const Photo &input, Photo &output) const
+{
+    QMap<QString, Entry>::const_iterator it = m_entries.find(input.getIdentity());
+    if ( it == m_entries.end() )
+        return false;
+    const Entry& previous = it.value();
+    if ( previous.generation != input.generation() ||
+         previous.tags != input.tags() )
+        return false;
+    output = previous.output;
+    output.setSequenceNumber(input.getSequenceNumber());
+    return true;
+}
+
+void PhotoMemo::record(const Photo &input, const Photo &output)
+{
+    Entry entry = { input.generation(), input.tags(), output };
+    m_entries.insert(input.getIdentity(), entry);
+}
+
+int PhotoMemo::count() const
+{
+    return m_entries.count();
+}
+
+void PhotoMemo::clear()
+{
+    m_entries.clear();
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#ifndef PHOTOMEMO_H
+#define PHOTOMEMO_H
+
+#include <QMap>
+#include <QString>
+
+#include "photo.h"
+
+/**
+ * @brief The PhotoMemo class remembers, by identity, what a 1:1 operator
+ * produced from each input photo. An entry is reused only if the input
+ * is still of the same generation, and carries the same tags. The sequence
+ * number is not part of the key, discarding a photo shifts the following
+ * ones, the reused output gets the one of the input. Only the outputs are
+ * kept, the previous inputs are not held in memory.
+ */
+class PhotoMemo
+{
+public:
+    PhotoMemo();
+
+    bool lookup(const Photo& input, Photo& output) const;
+    void record(const Photo& input, const Photo& output);
+
+    int count() const;
+    void clear();
+
+private:
+    typedef struct {
+        quint64 generation;
+        QMap<QString, QString> tags;
+        Photo output;
+    } Entry;
+    QMap<QString, Entry> m_entries;
+};
+
+#endif // PHOTOMEMO_H
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#include <Magick++.h>
+#include <algorithm>
+#include <cstdint>
+
+#include "planarbuffer.h"
+#include "photo.h"
+#include "hdr.h"
+#include "console.h"
+
+PlanarBuffer::PlanarBuffer(int width, int height) :
+    m_width(width),
+    m_height(height),
+    m_stride(0),
+    m_storage()
+{
+    const int perLine = DF_PLANAR_ALIGN / sizeof(float);
+    m_stride = ( width + perLine - 1 ) / perLine * perLine;
+    size_t planeSize = size_t(m_stride) * height;
+    m_storage.resize(planeSize * PlaneCount + perLine);
+    uintptr_t base = reinterpret_cast<uintptr_t>(m_storage.data());
+    uintptr_t aligned = ( base + DF_PLANAR_ALIGN - 1 ) & ~uintptr_t(DF_PLANAR_ALIGN - 1);
+    float *data = reinterpret_cast<float*>(aligned);
+    for (int i = 0 ; i < PlaneCount ; ++i )
+        m_planes[i] = data + planeSize * i;
+}
+
+void PlanarBuffer::fill(float value)
+{
+    std::fill(m_storage.begin(), m_storage.end(), value);
+}
+
+std::shared_ptr<PlanarBuffer> PlanarBuffer::fromImage(const Magick::Image &constImage, bool hdr)
+{
+    Magick::Image image(constImage);
+    int w = image.columns();
+    int h = image.rows();
+    std::shared_ptr<PlanarBuffer> buffer(new PlanarBuffer(w, h));
+    std::shared_ptr<FramePixels> cache(new FramePixels(image, false));
+    dfl_parallel_for(y, 0, h, 4, (), {
+        const Magick::PixelPacket *pixels = cache->getConst(y, 1);
+        if ( !pixels ) {
+            dflError(DF_NULL_PIXELS);
+            continue;
+        }
+        float *r = buffer->row(Red, y);
+        float *g = buffer->row(Green, y);
+        float *b = buffer->row(Blue, y);
+        if ( hdr ) {
+            for ( int x = 0 ; x < w ; ++x ) {
+                r[x] = fromHDR(pixels[x].red);
+                g[x] = fromHDR(pixels[x].green);
+                b[x] = fromHDR(pixels[x].blue);
+            }
+        }
+        else {
+            for ( int x = 0 ; x < w ; ++x ) {
+                r[x] = pixels[x].red;
+                g[x] = pixels[x].green;
+                b[x] = pixels[x].blue;
+            }
+        }
+    });
+    return buffer;
+}
+
+void PlanarBuffer::toImage(Magick::Image &image, bool hdr) const
+{
+    int w = m_width;
+    int h = m_height;
+    image = Magick::Image(Magick::Geometry(w, h), Magick::Color(0, 0, 0));
+    image.quantizeColorSpace(Magick::RGBColorspace);
+    std::shared_ptr<FramePixels> cache(new FramePixels(image, true));
+    dfl_parallel_for(y, 0, h, 4, (), {
+        Magick::PixelPacket *pixels = cache->get(y, 1);
+        if ( !pixels ) {
+            dflError(DF_NULL_PIXELS);
+            continue;
+        }
+        const float *r = row(Red, y);
+        const float *g = row(Green, y);
+        const float *b = row(Blue, y);
+        if ( hdr ) {
+            for ( int x = 0 ; x < w ; ++x ) {
+                pixels[x].red = toHDR(r[x]);
+                pixels[x].green = toHDR(g[x]);
+                pixels[x].blue = toHDR(b[x]);
+            }
+        }
+        else {
+            for ( int x = 0 ; x < w ; ++x ) {
+                pixels[x].red = clamp<quantum_t>(DF_ROUND(r[x]));
+                pixels[x].green = clamp<quantum_t>(DF_ROUND(g[x]));
+                pixels[x].blue = clamp<quantum_t>(DF_ROUND(b[x]));
+            }
+        }
+        cache->sync();
+    });
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#ifndef PLANARBUFFER_H
+#define PLANARBUFFER_H
+
+#include <QtGlobal>
+#include <memory>
+#include <vector>
+
+namespace Magick {
+class Image;
+}
+
+/* rows start on a cache line, room for 16 floats */
+#define DF_PLANAR_ALIGN 64
+
+/**
+ * @brief The PlanarBuffer class is an image held as three float planes,
+ * red, green and blue, each row aligned on a cache line.
+ *
+ * Samples are linear and unbounded, in the same unit as a 16 bits
+ * Quantum: HDR encoding only happens when converting from or to a
+ * Magick::Image, not in the operators loops.
+ */
+class PlanarBuffer
+{
+public:
+    typedef enum {
+        Red,
+        Green,
+        Blue,
+        PlaneCount
+    } Plane;
+
+    PlanarBuffer(int width, int height);
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    /**
+     * @brief stride
+     * @return the number of floats between two rows
+     */
+    int stride() const { return m_stride; }
+
+    float *row(Plane plane, int y)
+    { return m_planes[plane] + size_t(y) * m_stride; }
+    const float *row(Plane plane, int y) const
+    { return m_planes[plane] + size_t(y) * m_stride; }
+
+    void fill(float value);
+
+    /**
+     * @brief fromImage
+     * @param hdr image is HDR encoded, samples are decoded
+     */
+    static std::shared_ptr<PlanarBuffer> fromImage(const Magick::Image& image, bool hdr);
+    /**
+     * @brief toImage writes the samples in a new image
+     * @param hdr encode the samples as HDR, otherwise they are clamped
+     */
+    void toImage(Magick::Image& image, bool hdr) const;
+
+private:
+    Q_DISABLE_COPY(PlanarBuffer)
+    int m_width;
+    int m_height;
+    int m_stride;
+    std::vector<float> m_storage;
+    float *m_planes[PlaneCount];
+};
+
+#endif // PLANARBUFFER_H
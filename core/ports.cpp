@@ -34,6 +34,10 @@
 #include "console.h"
 #include "preferences.h"
 #include <cstdlib>
+#ifndef DF_WINDOWS
+# include <unistd.h>
+# include <time.h>
+#endif
 
 #ifdef DF_WINDOWS
 int vasprintf(char **res, char const *fmt, va_list args)
@@ -145,3 +149,40 @@ void init_platform()
     init_osx();
 #endif
 }
+
+qint64 dfl_physical_memory()
+{
+#ifdef DF_WINDOWS
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if ( !GlobalMemoryStatusEx(&status) )
+        return 0;
+    return status.ullTotalPhys;
+#else
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if ( pages < 0 || pageSize < 0 )
+        return 0;
+    return qint64(pages) * pageSize;
+#endif
+}
+
+qint64 dfl_thread_cpu_time()
+{
+#ifdef DF_WINDOWS
+    FILETIME creation, exit, kernel, user;
+    if ( !GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user) )
+        return 0;
+    /* 100ns units */
+    quint64 k = (quint64(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+    quint64 u = (quint64(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+    return qint64((k + u) / 10);
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec ts;
+    if ( clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) )
+        return 0;
+    return qint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#else
+    return 0;
+#endif
+}
@@ -66,6 +66,8 @@ typedef long long int64_t;
 # define DF_TRAP() do { ::raise(SIGTRAP); } while(0)
 # define atomic_incr(ptr) do { __sync_fetch_and_add ((ptr), 1); } while(0)
 # define atomic_decr(ptr) do { __sync_fetch_and_add ((ptr), -1); } while(0)
+# define atomic_add(ptr, value) do { __sync_fetch_and_add ((ptr), (value)); } while(0)
+# define DF_THREAD_LOCAL __thread
 
 #else /* not GCC */
 
@@ -73,6 +75,8 @@ typedef long long int64_t;
 # define DF_TRAP() __debugbreak()
 # define atomic_incr(ptr) do { InterlockedIncrement ((ptr)); } while(0)
 # define atomic_decr(ptr) do { InterlockedDecrement ((ptr)); } while(0)
+# define atomic_add(ptr, value) do { InterlockedExchangeAdd ((ptr), (value)); } while(0)
+# define DF_THREAD_LOCAL __declspec(thread)
 #endif /* __GNUC__ */
 
 # ifndef M_PI
@@ -110,5 +114,15 @@ int vasprintf(char **strp, const char *fmt, va_list ap);
 #include "ordinary.h"
 
 void init_platform();
+/**
+ * @brief dfl_physical_memory
+ * @return the amount of physical memory in bytes, 0 if unknown
+ */
+qint64 dfl_physical_memory();
+/**
+ * @brief dfl_thread_cpu_time
+ * @return the CPU time used by the calling thread in microseconds, 0 if unknown
+ */
+qint64 dfl_thread_cpu_time();
 
 #endif // PORTS_H
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QCoreApplication>
+#include <Magick++.h>
+
+#include "profiler.h"
+#include "preferences.h"
+#include "ports.h"
+
+std::atomic<bool> Profiler::s_enabled(false);
+
+static std::atomic<int> s_nextTid(0);
+static DF_THREAD_LOCAL int t_tid = 0;
+
+static int currentTid()
+{
+    if ( 0 == t_tid )
+        t_tid = ++s_nextTid;
+    return t_tid;
+}
+
+Profiler::Profiler() :
+    m_clock(),
+    m_mutex(),
+    m_events()
+{
+    m_clock.start();
+}
+
+Profiler *Profiler::instance()
+{
+    static Profiler *profiler = new Profiler;
+    return profiler;
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled);
+}
+
+qint64 Profiler::now() const
+{
+    return m_clock.nsecsElapsed() / 1000;
+}
+
+void Profiler::complete(const char *category, const QString &name,
+                        qint64 start, qint64 duration,
+                        const QVariantMap &args)
+{
+    Event event = { 'X', category, name, start, duration, currentTid(), args };
+    record(event);
+}
+
+qint64 Profiler::samplePixels()
+{
+    qint64 pixels = qint64(MagickCore::GetMagickResource(MagickCore::AreaResource));
+    QVariantMap args;
+    args["pixels"] = pixels;
+    Event event = { 'C', "memory", "resident pixels", now(), 0, 0, args };
+    record(event);
+    return pixels;
+}
+
+void Profiler::record(const Event &event)
+{
+    QMutexLocker lock(&m_mutex);
+    m_events.push_back(event);
+}
+
+bool Profiler::writeTrace(const QString &filename)
+{
+    QJsonArray events;
+    QJsonObject processName;
+    processName["name"] = QCoreApplication::applicationName();
+    QJsonObject process;
+    process["name"] = "process_name";
+    process["ph"] = "M";
+    process["pid"] = 1;
+    process["args"] = processName;
+    events.append(process);
+    {
+        QMutexLocker lock(&m_mutex);
+        foreach(const Event& e, m_events) {
+            QJsonObject obj;
+            obj["name"] = e.name;
+            obj["cat"] = e.category;
+            obj["ph"] = QString(QChar(e.phase));
+            obj["ts"] = e.start;
+            if ( e.phase == 'X' )
+                obj["dur"] = e.duration;
+            obj["pid"] = 1;
+            obj["tid"] = e.tid;
+            if ( !e.args.isEmpty() )
+                obj["args"] = QJsonObject::fromVariantMap(e.args);
+            events.append(obj);
+        }
+    }
+    QJsonObject root;
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+    QFile file(filename);
+    if ( !file.open(QIODevice::WriteOnly|QIODevice::Truncate) )
+        return false;
+    QByteArray data = QJsonDocument(root).toJson(QJsonDocument::Compact);
+    return file.write(data) == data.size();
+}
+
+void Profiler::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_events.clear();
+}
+
+ProfileScope::ProfileScope(const char *category, const QString &name) :
+    m_active(Profiler::enabled()),
+    m_category(category),
+    m_name(),
+    m_start(0),
+    m_cpuStart(0),
+    m_pixels(0),
+    m_args()
+{
+    if ( !m_active )
+        return;
+    m_name = name;
+    m_pixels = Profiler::instance()->samplePixels();
+    m_cpuStart = dfl_thread_cpu_time();
+    m_start = Profiler::instance()->now();
+}
+
+ProfileScope::~ProfileScope()
+{
+    if ( !m_active )
+        return;
+    Profiler *profiler = Profiler::instance();
+    qint64 duration = profiler->now() - m_start;
+    m_args["cpu_us"] = dfl_thread_cpu_time() - m_cpuStart;
+    m_args["resident_pixels"] = qMax(m_pixels, profiler->samplePixels());
+    profiler->complete(m_category, m_name, m_start, duration, m_args);
+}
+
+void ProfileScope::setArg(const QString &key, const QVariant &value)
+{
+    if ( m_active )
+        m_args[key] = value;
+}
+
+ProfileRegion::ProfileRegion(const char *file, int line, int threads) :
+    m_active(Profiler::enabled()),
+    m_file(file),
+    m_line(line),
+    m_threads(threads),
+    m_start(0),
+    m_busy(0),
+    m_peakAtWork(0)
+{
+    if ( m_active )
+        m_start = Profiler::instance()->now();
+}
+
+ProfileRegion::~ProfileRegion()
+{
+    if ( !m_active )
+        return;
+    Profiler *profiler = Profiler::instance();
+    qint64 duration = profiler->now() - m_start;
+    QVariantMap args;
+    args["threads"] = m_threads;
+    args["busy_us"] = qint64(m_busy);
+    args["peak_at_work"] = qint64(m_peakAtWork);
+    if ( duration > 0 )
+        args["utilization"] = double(m_busy) / (double(duration) * m_threads);
+    profiler->complete("parallel_for",
+                       QString("%0:%1").arg(m_file).arg(m_line),
+                       m_start, duration, args);
+}
+
+/**
+ * @brief ProfileRegion::begin called by AtWork once the iteration
+ * is counted at work
+ * @return the start time of the iteration
+ */
+qint64 ProfileRegion::begin()
+{
+    if ( !m_active )
+        return 0;
+    long atWork = long(preferences->getAtWork());
+    long peak = m_peakAtWork.load(std::memory_order_relaxed);
+    while ( atWork > peak &&
+            !m_peakAtWork.compare_exchange_weak(peak, atWork) )
+        ;
+    return Profiler::instance()->now();
+}
+
+void ProfileRegion::end(qint64 start)
+{
+    if ( m_active )
+        m_busy += Profiler::instance()->now() - start;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <atomic>
+
+/**
+ * @brief The Profiler class records what the workers spend their time on
+ * and exports it as a Chrome trace, readable by chrome://tracing and
+ * Perfetto
+ *
+ * Recording is off unless setEnabled() is called, the probes then
+ * cost a flag test.
+ */
+class Profiler
+{
+public:
+    static Profiler *instance();
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool enabled);
+
+    /**
+     * @brief now
+     * @return microseconds since the profiler was created
+     */
+    qint64 now() const;
+    void complete(const char *category, const QString& name,
+                  qint64 start, qint64 duration,
+                  const QVariantMap& args = QVariantMap());
+    /**
+     * @brief samplePixels records the pixels held by ImageMagick caches
+     * on the resident pixels counter track
+     * @return the pixels held
+     */
+    qint64 samplePixels();
+
+    bool writeTrace(const QString& filename);
+    void clear();
+
+private:
+    Profiler();
+    Q_DISABLE_COPY(Profiler)
+
+    struct Event {
+        char phase;
+        const char *category;
+        QString name;
+        qint64 start;
+        qint64 duration;
+        int tid;
+        QVariantMap args;
+    };
+    void record(const Event& event);
+
+    QElapsedTimer m_clock;
+    QMutex m_mutex;
+    QVector<Event> m_events;
+    static std::atomic<bool> s_enabled;
+};
+
+/**
+ * @brief The ProfileScope class records a complete event with the wall
+ * and CPU time of the calling thread between construction and destruction
+ */
+class ProfileScope
+{
+public:
+    ProfileScope(const char *category, const QString& name);
+    ~ProfileScope();
+    bool active() const { return m_active; }
+    void setArg(const QString& key, const QVariant& value);
+
+private:
+    Q_DISABLE_COPY(ProfileScope)
+    bool m_active;
+    const char *m_category;
+    QString m_name;
+    qint64 m_start;
+    qint64 m_cpuStart;
+    qint64 m_pixels;
+    QVariantMap m_args;
+};
+
+/**
+ * @brief The ProfileRegion class measures a dfl_parallel_for, the AtWork
+ * guards of its iterations accumulate the time the threads were busy
+ */
+class ProfileRegion
+{
+public:
+    ProfileRegion(const char *file, int line, int threads);
+    ~ProfileRegion();
+    qint64 begin();
+    void end(qint64 start);
+
+private:
+    Q_DISABLE_COPY(ProfileRegion)
+    bool m_active;
+    const char *m_file;
+    int m_line;
+    int m_threads;
+    qint64 m_start;
+    std::atomic<qint64> m_busy;
+    std::atomic<long> m_peakAtWork;
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#ifndef PROGRESSCOUNTER_H
+#define PROGRESSCOUNTER_H
+
+#include <QtGlobal>
+#include <atomic>
+
+/**
+ * @brief The ProgressCounter class holds the progress of a worker as a
+ * single atomic word, the done count in the high half and the total in
+ * the low half. The worker threads update it without locking and the GUI
+ * samples it at its own pace
+ */
+class ProgressCounter
+{
+public:
+    ProgressCounter() :
+        m_value(pack(0, 1))
+    {}
+
+    void set(int p, int c) {
+        m_value.store(pack(p, c), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief advance
+     * @param steps added to the done count, the total is left untouched
+     */
+    void advance(int steps = 1) {
+        m_value.fetch_add(quint64(quint32(steps)) << 32, std::memory_order_relaxed);
+    }
+
+    void get(int& p, int& c) const {
+        quint64 v = m_value.load(std::memory_order_relaxed);
+        p = int(quint32(v >> 32));
+        c = int(quint32(v));
+    }
+
+private:
+    static quint64 pack(int p, int c) {
+        return (quint64(quint32(p)) << 32) | quint32(c);
+    }
+    std::atomic<quint64> m_value;
+};
+
+#endif // PROGRESSCOUNTER_H
@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#include <QDataStream>
+#include <QFile>
+#include <QBuffer>
+#include <QDir>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QMutex>
+#include <QStandardPaths>
+
+#include "resultcache.h"
+#include "planarbuffer.h"
+#include "ordinary.h"
+#include "console.h"
+
+#define DF_CACHE_MAGIC 0x6466726306ULL
+#define DF_CACHE_VERSION 2
+
+/* the workers store their results concurrently */
+static QMutex pruneMutex;
+static qint64 cacheCeiling = 0;
+
+QString ResultCache::directory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/results";
+}
+
+QString ResultCache::path(const QByteArray &key)
+{
+    return directory() + "/" + QString::fromLatin1(key) + ".dfr";
+}
+
+bool ResultCache::contains(const QByteArray &key)
+{
+    QString filename = path(key);
+    if ( !QFile::exists(filename) )
+        return false;
+    /* a hit is about to be loaded, it must not be the next one pruned */
+    touch(filename);
+    return true;
+}
+
+bool ResultCache::store(const QByteArray &key, const QVector<QVector<Photo> > &outputs)
+{
+    if ( !QDir().mkpath(directory()) ) {
+        dflWarning(Console::tr("Result cache: could not create %0").arg(directory()));
+        return false;
+    }
+    if ( !write(path(key), outputs) )
+        return false;
+    prune();
+    return true;
+}
+
+bool ResultCache::load(const QByteArray &key, QVector<QVector<Photo> > &outputs)
+{
+    QString filename = path(key);
+    touch(filename);
+    return read(filename, outputs);
+}
+
+void ResultCache::setCeiling(qint64 bytes)
+{
+    {
+        QMutexLocker lock(&pruneMutex);
+        cacheCeiling = bytes;
+    }
+    prune();
+}
+
+qint64 ResultCache::ceiling()
+{
+    QMutexLocker lock(&pruneMutex);
+    return cacheCeiling;
+}
+
+/**
+ * @brief ResultCache::touch
+ * the modification time of the entries is their last use
+ */
+void ResultCache::touch(const QString &filename)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    QFile file(filename);
+    if ( file.open(QIODevice::Append) )
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+#else
+    /* entries are then pruned in the order they were stored */
+    Q_UNUSED(filename);
+#endif
+}
+
+/**
+ * @brief ResultCache::prune removes the least recently used entries until the
+ * cache fits its ceiling, the most recent one is always kept
+ */
+void ResultCache::prune()
+{
+    QMutexLocker lock(&pruneMutex);
+    if ( cacheCeiling <= 0 )
+        return;
+    QFileInfoList entries = QDir(directory()).entryInfoList(QStringList() << "*.dfr",
+                                                            QDir::Files, QDir::Time);
+    qint64 size = 0;
+    for (int i = 0 ; i < entries.count() ; ++i ) {
+        size += entries[i].size();
+        if ( i == 0 || size <= cacheCeiling )
+            continue;
+        if ( QFile::remove(entries[i].filePath()) )
+            dflDebug(Console::tr("Result cache: pruned %0").arg(entries[i].fileName()));
+    }
+}
+
+bool ResultCache::write(const QString &filename, const QVector<QVector<Photo> > &outputs)
+{
+    QString tmpFilename = filename + ".tmp";
+    QFile file(tmpFilename);
+    if ( !file.open(QIODevice::WriteOnly) ) {
+        dflWarning(Console::tr("Result cache: could not open %0").arg(tmpFilename));
+        return false;
+    }
+    QDataStream stream(&file);
+    stream << quint64(DF_CACHE_MAGIC) << qint32(DF_CACHE_VERSION);
+    stream << qint32(outputs.count());
+    bool success = true;
+    try {
+        foreach(const QVector<Photo>& output, outputs) {
+            stream << qint32(output.count());
+            foreach(const Photo& photo, output) {
+                /* planar photos are kept at full precision */
+                bool planar = photo.isPlanar();
+                stream << photo.getIdentity()
+                       << qint32(photo.getSequenceNumber())
+                       << photo.tags()
+                       << qint8(planar);
+                success = success &&
+                        ( planar ? writePlanar(stream, *photo.planar())
+                                 : writeImage(stream, photo.image()) ) &&
+                        writeImage(stream, photo.curve());
+                if ( !success )
+                    break;
+            }
+            if ( !success )
+                break;
+        }
+    }
+    catch (std::exception &e) {
+        dflWarning(Console::tr("Result cache: %0").arg(e.what()));
+        success = false;
+    }
+    file.close();
+    if ( !success || stream.status() != QDataStream::Ok ) {
+        QFile::remove(tmpFilename);
+        return false;
+    }
+    QFile::remove(filename);
+    return QFile::rename(tmpFilename, filename);
+}
+
+bool ResultCache::read(const QString &filename, QVector<QVector<Photo> > &outputs)
+{
+    QFile file(filename);
+    if ( !file.open(QIODevice::ReadOnly) )
+        return false;
+    /* pixels are paged in from the mapping rather than copied
+     * through the file buffer */
+    QBuffer buffer;
+    uchar *map = file.map(0, file.size());
+    if ( map ) {
+        buffer.setData(QByteArray::fromRawData(reinterpret_cast<const char*>(map), file.size()));
+        buffer.open(QIODevice::ReadOnly);
+    }
+    QDataStream stream(map ? static_cast<QIODevice*>(&buffer) : static_cast<QIODevice*>(&file));
+    quint64 magic;
+    qint32 version;
+    qint32 n_outputs;
+    stream >> magic >> version >> n_outputs;
+    if ( magic != DF_CACHE_MAGIC || version != DF_CACHE_VERSION ||
+         n_outputs != outputs.count() ) {
+        dflWarning(Console::tr("Result cache: invalid entry %0").arg(file.fileName()));
+        return false;
+    }
+    try {
+        for (int i = 0 ; i < n_outputs ; ++i ) {
+            qint32 count;
+            stream >> count;
+            for (int j = 0 ; j < count ; ++j ) {
+                QString identity;
+                qint32 sequenceNumber;
+                QMap<QString, QString> tags;
+                qint8 planar;
+                stream >> identity >> sequenceNumber >> tags >> planar;
+                std::shared_ptr<PlanarBuffer> buffer;
+                Magick::Image image;
+                Magick::Image curve;
+                if ( ( planar ? !readPlanar(stream, buffer)
+                              : !readImage(stream, image) ) ||
+                     !readImage(stream, curve) )
+                    return false;
+                Photo photo = planar ? Photo(Photo::Linear) : Photo(image, Photo::Linear);
+                photo.curve() = curve;
+                for (QMap<QString, QString>::iterator it = tags.begin() ;
+                     it != tags.end() ;
+                     ++it )
+                    photo.setTag(it.key(), it.value());
+                photo.setIdentity(identity);
+                photo.setSequenceNumber(sequenceNumber);
+                if ( planar )
+                    photo.setPlanar(buffer);
+                outputs[i].push_back(photo);
+            }
+        }
+    }
+    catch (std::exception &e) {
+        dflWarning(Console::tr("Result cache: %0").arg(e.what()));
+        return false;
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+bool ResultCache::writeImage(QDataStream &stream, const Magick::Image &constImage)
+{
+    Magick::Image image(constImage);
+    int w = image.columns(),
+            h = image.rows();
+    stream << qint32(w) << qint32(h);
+    QVector<quint16> row(w*3);
+    std::shared_ptr<Ordinary::Pixels> cache(new Ordinary::Pixels(image));
+    for ( int y = 0 ; y < h ; ++y ) {
+        const Magick::PixelPacket *pixels = cache->getConst(0, y, w, 1);
+        if ( !pixels ) {
+            dflError(DF_NULL_PIXELS);
+            return false;
+        }
+        for ( int x = 0 ; x < w ; ++x ) {
+            row[x*3+0] = pixels[x].red;
+            row[x*3+1] = pixels[x].green;
+            row[x*3+2] = pixels[x].blue;
+        }
+        int len = w*3*sizeof(quint16);
+        if ( stream.writeRawData(reinterpret_cast<const char*>(row.constData()), len) != len )
+            return false;
+    }
+    return true;
+}
+
+bool ResultCache::readImage(QDataStream &stream, Magick::Image &image)
+{
+    qint32 w, h;
+    stream >> w >> h;
+    if ( stream.status() != QDataStream::Ok || w <= 0 || h <= 0 )
+        return false;
+    image = Magick::Image(Magick::Geometry(w, h), Magick::Color(0,0,0));
+    image.quantizeColorSpace(Magick::RGBColorspace);
+    image.modifyImage();
+    QVector<quint16> row(w*3);
+    std::shared_ptr<Ordinary::Pixels> cache(new Ordinary::Pixels(image));
+    for ( int y = 0 ; y < h ; ++y ) {
+        int len = w*3*sizeof(quint16);
+        if ( stream.readRawData(reinterpret_cast<char*>(row.data()), len) != len )
+            return false;
+        Magick::PixelPacket *pixels = cache->get(0, y, w, 1);
+        if ( !pixels ) {
+            dflError(DF_NULL_PIXELS);
+            return false;
+        }
+        for ( int x = 0 ; x < w ; ++x ) {
+            pixels[x].red = row[x*3+0];
+            pixels[x].green = row[x*3+1];
+            pixels[x].blue = row[x*3+2];
+        }
+        cache->sync();
+    }
+    return true;
+}
+
+bool ResultCache::writePlanar(QDataStream &stream, const PlanarBuffer &buffer)
+{
+    int w = buffer.width(),
+            h = buffer.height();
+    stream << qint32(w) << qint32(h);
+    int len = w*sizeof(float);
+    for ( int plane = 0 ; plane < PlanarBuffer::PlaneCount ; ++plane ) {
+        for ( int y = 0 ; y < h ; ++y ) {
+            const float *row = buffer.row(PlanarBuffer::Plane(plane), y);
+            if ( stream.writeRawData(reinterpret_cast<const char*>(row), len) != len )
+                return false;
+        }
+    }
+    return true;
+}
+
+bool ResultCache::readPlanar(QDataStream &stream, std::shared_ptr<PlanarBuffer> &buffer)
+{
+    qint32 w, h;
+    stream >> w >> h;
+    if ( stream.status() != QDataStream::Ok || w <= 0 || h <= 0 )
+        return false;
+    buffer.reset(new PlanarBuffer(w, h));
+    int len = w*sizeof(float);
+    for ( int plane = 0 ; plane < PlanarBuffer::PlaneCount ; ++plane ) {
+        for ( int y = 0 ; y < h ; ++y ) {
+            float *row = buffer->row(PlanarBuffer::Plane(plane), y);
+            if ( stream.readRawData(reinterpret_cast<char*>(row), len) != len )
+                return false;
+        }
+    }
+    return true;
+}
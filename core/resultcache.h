@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include "photo.h"
+
+class QDataStream;
+class PlanarBuffer;
+
+/* results computed faster than that are not worth a disk round trip */
+#define DF_CACHE_MIN_ELAPSED 1000
+
+/**
+ * @brief The ResultCache class is a persistent, content addressed store of
+ * operator outputs. Keys come from Operator::cacheKey(). Past its ceiling,
+ * the least recently used entries are removed when a new one is stored
+ */
+class ResultCache
+{
+public:
+    static QString directory();
+    static QString path(const QByteArray& key);
+    static bool contains(const QByteArray& key);
+    static bool store(const QByteArray& key, const QVector<QVector<Photo> >& outputs);
+    static bool load(const QByteArray& key, QVector<QVector<Photo> >& outputs);
+
+    /**
+     * @brief setCeiling
+     * @param bytes size of the cache directory, 0 for unlimited
+     */
+    static void setCeiling(qint64 bytes);
+    static qint64 ceiling();
+
+    /* the same format, outside of the cache directory */
+    static bool write(const QString& filename, const QVector<QVector<Photo> >& outputs);
+    static bool read(const QString& filename, QVector<QVector<Photo> >& outputs);
+
+private:
+    static void touch(const QString& filename);
+    static void prune();
+    static bool writeImage(QDataStream& stream, const Magick::Image& image);
+    static bool readImage(QDataStream& stream, Magick::Image& image);
+    static bool writePlanar(QDataStream& stream, const PlanarBuffer& buffer);
+    static bool readPlanar(QDataStream& stream, std::shared_ptr<PlanarBuffer>& buffer);
+};
+
+#endif // RESULTCACHE_H
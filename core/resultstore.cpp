@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#include <QDir>
+#include <QCoreApplication>
+
+#include "resultstore.h"
+#include "operatoroutput.h"
+#include "preferences.h"
+
+ResultStore::ResultStore() :
+    m_lru(),
+    m_ceiling(0)
+{
+}
+
+ResultStore *ResultStore::instance()
+{
+    static ResultStore store;
+    return &store;
+}
+
+void ResultStore::setCeiling(qint64 bytes)
+{
+    m_ceiling = bytes;
+    enforce(NULL);
+}
+
+qint64 ResultStore::ceiling() const
+{
+    return m_ceiling;
+}
+
+qint64 ResultStore::inMemory() const
+{
+    qint64 bytes = 0;
+    foreach(OperatorOutput *output, m_lru)
+        bytes += output->resultFootprint();
+    return bytes;
+}
+
+void ResultStore::touch(OperatorOutput *output)
+{
+    m_lru.removeOne(output);
+    m_lru.push_back(output);
+    enforce(output);
+}
+
+void ResultStore::forget(OperatorOutput *output)
+{
+    m_lru.removeOne(output);
+}
+
+QString ResultStore::spillFilename(OperatorOutput *output, int serial) const
+{
+    return QDir(preferences->tmpDir()).absoluteFilePath(
+                QString("darkflow-%0-%1-%2.dfr")
+                .arg(QString::number(quintptr(output), 16))
+                .arg(serial)
+                .arg(QString::number(qint64(QCoreApplication::applicationPid()))));
+}
+
+void ResultStore::enforce(OperatorOutput *keep)
+{
+    if ( m_ceiling <= 0 )
+        return;
+    qint64 bytes = inMemory();
+    while ( bytes > m_ceiling && !m_lru.isEmpty() ) {
+        OperatorOutput *coldest = m_lru.first();
+        if ( coldest == keep )
+            break;
+        m_lru.removeFirst();
+        bytes -= coldest->resultFootprint();
+        coldest->spill();
+    }
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#ifndef RESULTSTORE_H
+#define RESULTSTORE_H
+
+#include <QList>
+#include <QString>
+
+class OperatorOutput;
+
+/**
+ * @brief The ResultStore class bounds the memory held by the results of
+ * up to date operators. Least recently used results are spilled to files
+ * in the temporary directory by a background thread, and read back when
+ * they are needed again.
+ * It lives in the main thread, like the results themselves.
+ */
+class ResultStore
+{
+public:
+    static ResultStore *instance();
+
+    /**
+     * @brief setCeiling
+     * @param bytes results held in memory, 0 for unlimited
+     */
+    void setCeiling(qint64 bytes);
+    qint64 ceiling() const;
+    qint64 inMemory() const;
+
+    void touch(OperatorOutput *output);
+    void forget(OperatorOutput *output);
+    QString spillFilename(OperatorOutput *output, int serial) const;
+
+private:
+    ResultStore();
+    Q_DISABLE_COPY(ResultStore)
+    void enforce(OperatorOutput *keep);
+
+    QList<OperatorOutput*> m_lru;
+    qint64 m_ceiling;
+};
+
+#endif // RESULTSTORE_H
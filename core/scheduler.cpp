@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#include <QMutexLocker>
+
+#include "scheduler.h"
+#include "operatorworker.h"
+
+Scheduler::Scheduler(int maxWorkers, qint64 memoryBudget) :
+    m_mutex(),
+    m_cond(),
+    m_waiting(),
+    m_running(),
+    m_memoryInUse(0),
+    m_maxWorkers(maxWorkers),
+    m_memoryBudget(memoryBudget),
+    m_order(0)
+{
+}
+
+void Scheduler::setMaxWorkers(int maxWorkers)
+{
+    QMutexLocker lock(&m_mutex);
+    m_maxWorkers = qMax(1, maxWorkers);
+    m_cond.wakeAll();
+}
+
+void Scheduler::setMemoryBudget(qint64 memoryBudget)
+{
+    QMutexLocker lock(&m_mutex);
+    m_memoryBudget = qMax(qint64(0), memoryBudget);
+    m_cond.wakeAll();
+}
+
+bool Scheduler::acquire(OperatorWorker *worker, int priority, qint64 footprint)
+{
+    QMutexLocker lock(&m_mutex);
+    Request request = { worker, priority, footprint, m_order++ };
+    m_waiting.push_back(request);
+    bool reported = false;
+    forever {
+        if ( elect() == worker ) {
+            for (int i = 0 ; i < m_waiting.count() ; ++i ) {
+                if ( m_waiting[i].worker == worker ) {
+                    m_waiting.removeAt(i);
+                    break;
+                }
+            }
+            m_running[worker] = footprint;
+            m_memoryInUse += footprint;
+            // the next one may fit as well
+            m_cond.wakeAll();
+            return true;
+        }
+        if ( worker->aborted() ) {
+            for (int i = 0 ; i < m_waiting.count() ; ++i ) {
+                if ( m_waiting[i].worker == worker ) {
+                    m_waiting.removeAt(i);
+                    break;
+                }
+            }
+            m_cond.wakeAll();
+            return false;
+        }
+        if ( !reported && m_running.count() < m_maxWorkers && !fits(request) ) {
+            worker->dflDebug(QObject::tr("Delayed, %0 MB would exceed the memory budget")
+                             .arg(footprint >> 20));
+            reported = true;
+        }
+        m_cond.wait(&m_mutex, 50);
+    }
+}
+
+void Scheduler::release(OperatorWorker *worker)
+{
+    QMutexLocker lock(&m_mutex);
+    m_memoryInUse -= m_running.take(worker);
+    m_cond.wakeAll();
+}
+
+qint64 Scheduler::memoryInUse()
+{
+    QMutexLocker lock(&m_mutex);
+    return m_memoryInUse;
+}
+
+bool Scheduler::fits(const Scheduler::Request &request) const
+{
+    if ( m_running.count() >= m_maxWorkers )
+        return false;
+    /* a lone worker always runs, whatever its size */
+    if ( m_memoryBudget == 0 || m_running.isEmpty() )
+        return true;
+    return m_memoryInUse + request.footprint <= m_memoryBudget;
+}
+
+OperatorWorker *Scheduler::elect() const
+{
+    int best = -1;
+    for (int i = 0 ; i < m_waiting.count() ; ++i ) {
+        const Request& request = m_waiting[i];
+        if ( !fits(request) )
+            continue;
+        if ( best < 0 ||
+             request.priority > m_waiting[best].priority ||
+             ( request.priority == m_waiting[best].priority &&
+               request.order < m_waiting[best].order ) )
+            best = i;
+    }
+    return best < 0 ? NULL : m_waiting[best].worker;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QList>
+#include <QMap>
+
+class OperatorWorker;
+
+/**
+ * @brief The Scheduler class decides which of the workers ready to run
+ * actually run. The ones on the longest path to a sink go first, within
+ * the worker count and the memory budget. A worker that does not fit in
+ * the remaining budget waits while smaller ones behind it may start.
+ */
+class Scheduler
+{
+public:
+    Scheduler(int maxWorkers, qint64 memoryBudget);
+
+    void setMaxWorkers(int maxWorkers);
+    /**
+     * @brief setMemoryBudget
+     * @param memoryBudget in bytes, 0 for unlimited
+     */
+    void setMemoryBudget(qint64 memoryBudget);
+
+    /**
+     * @brief acquire blocks until the worker is elected
+     * @param priority critical path length of the operator
+     * @param footprint estimated memory footprint in bytes
+     * @return false if the worker was aborted while waiting
+     */
+    bool acquire(OperatorWorker *worker, int priority, qint64 footprint);
+    void release(OperatorWorker *worker);
+
+    qint64 memoryInUse();
+
+private:
+    Q_DISABLE_COPY(Scheduler)
+    typedef struct {
+        OperatorWorker *worker;
+        int priority;
+        qint64 footprint;
+        quint64 order;
+    } Request;
+
+    QMutex m_mutex;
+    QWaitCondition m_cond;
+    QList<Request> m_waiting;
+    QMap<OperatorWorker*, qint64> m_running;
+    qint64 m_memoryInUse;
+    int m_maxWorkers;
+    qint64 m_memoryBudget;
+    quint64 m_order;
+
+    bool fits(const Request& request) const;
+    OperatorWorker *elect() const;
+};
+
+#endif // SCHEDULER_H
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#include "threadbudget.h"
+#include "ports.h"
+
+/* share of the section whose body the thread runs, -1 outside of any */
+static DF_THREAD_LOCAL int t_share = -1;
+
+ThreadBudget::ThreadBudget() :
+    m_threads(1),
+    m_available(1)
+{
+}
+
+ThreadBudget *ThreadBudget::instance()
+{
+    static ThreadBudget budget;
+    return &budget;
+}
+
+void ThreadBudget::setThreads(int threads)
+{
+    threads = qMax(1, threads);
+    /* sections running keep their threads, they are given back later */
+    int previous = m_threads.exchange(threads);
+    m_available += threads - previous;
+}
+
+int ThreadBudget::threads() const
+{
+    return m_threads;
+}
+
+int ThreadBudget::acquire(int wanted)
+{
+    int available = m_available.load();
+    for (;;) {
+        int reserved = qMin(wanted, available);
+        if ( reserved <= 0 )
+            return 0;
+        if ( m_available.compare_exchange_weak(available, available - reserved) )
+            return reserved;
+    }
+}
+
+void ThreadBudget::release(int count)
+{
+    if ( count > 0 )
+        m_available += count;
+}
+
+int ThreadBudget::available() const
+{
+    return qMax(0, m_available.load());
+}
+
+DfThreads::DfThreads(int wanted) :
+    m_reserved(0),
+    m_count(1),
+    m_share(0)
+{
+    ThreadBudget *budget = ThreadBudget::instance();
+    if ( t_share < 0 ) {
+        m_reserved = budget->acquire(wanted);
+        m_count = qMax(1, m_reserved);
+    }
+    else {
+        m_reserved = budget->acquire(qMin(wanted - 1, t_share));
+        m_count = 1 + m_reserved;
+    }
+    m_share = budget->available() / m_count;
+}
+
+DfThreads::~DfThreads()
+{
+    ThreadBudget::instance()->release(m_reserved);
+}
+
+DfSectionMember::DfSectionMember(int share) :
+    m_previous(t_share)
+{
+    t_share = share;
+}
+
+DfSectionMember::~DfSectionMember()
+{
+    t_share = m_previous;
+}
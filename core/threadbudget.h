@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#ifndef THREADBUDGET_H
+#define THREADBUDGET_H
+
+#include <QtGlobal>
+#include <atomic>
+
+/**
+ * @brief The ThreadBudget class shares the cores between all the parallel
+ * sections running at the same time. Row loops, frame loops, FFTW plans
+ * and ImageMagick calls reserve their threads here instead of each one
+ * assuming it owns the machine, so concurrent workers and nested loops
+ * split the cores rather than multiply the threads.
+ */
+class ThreadBudget
+{
+public:
+    static ThreadBudget *instance();
+
+    void setThreads(int threads);
+    int threads() const;
+
+    /**
+     * @brief acquire reserves up to wanted threads, without waiting
+     * @return the number of threads reserved, possibly 0
+     */
+    int acquire(int wanted);
+    void release(int count);
+    int available() const;
+
+private:
+    ThreadBudget();
+    Q_DISABLE_COPY(ThreadBudget)
+
+    std::atomic<int> m_threads;
+    std::atomic<int> m_available;
+};
+
+/**
+ * @brief The DfThreads class holds the threads of one parallel section,
+ * the calling thread always runs it even if nothing is left to reserve.
+ *
+ * Nested in the body of another section, the calling thread already holds a
+ * token of the enclosing one and only the extra threads are reserved, no
+ * more than the share of the enclosing section, so that sibling sections
+ * split what the enclosing one left instead of the first one taking it all.
+ */
+class DfThreads
+{
+public:
+    explicit DfThreads(int wanted);
+    ~DfThreads();
+    int count() const { return m_count; }
+    /**
+     * @brief share
+     * @return the extra threads each member of the section may reserve for
+     * the sections nested in its body
+     */
+    int share() const { return m_share; }
+
+private:
+    Q_DISABLE_COPY(DfThreads)
+    int m_reserved;
+    int m_count;
+    int m_share;
+};
+
+/**
+ * @brief The DfSectionMember class marks the calling thread as running the
+ * body of a section of the given share until the scope ends
+ */
+class DfSectionMember
+{
+public:
+    explicit DfSectionMember(int share);
+    ~DfSectionMember();
+
+private:
+    Q_DISABLE_COPY(DfSectionMember)
+    int m_previous;
+};
+
+#endif // THREADBUDGET_H
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#include "tonecurve.h"
+#include "photo.h"
+#include "lutbased.h"
+#include "console.h"
+
+using Magick::Quantum;
+
+ToneCurve::ToneCurve() :
+    m_image(),
+    m_luts()
+{
+}
+
+ToneCurve::ToneCurve(const Magick::Image &base) :
+    m_image(base),
+    m_luts()
+{
+}
+
+void ToneCurve::compose(std::shared_ptr<const quantum_t> lut)
+{
+    m_luts.push_back(lut);
+}
+
+const Magick::Image &ToneCurve::image() const
+{
+    evaluate();
+    return m_image;
+}
+
+Magick::Image &ToneCurve::image()
+{
+    evaluate();
+    return m_image;
+}
+
+bool ToneCurve::isSharedWith(const ToneCurve &other) const
+{
+    if ( m_image.constImage() != other.m_image.constImage() ||
+         m_luts.count() != other.m_luts.count() )
+        return false;
+    for ( int i = 0, s = m_luts.count() ; i < s ; ++i )
+        if ( m_luts[i] != other.m_luts[i] )
+            return false;
+    return true;
+}
+
+void ToneCurve::evaluate() const
+{
+    if ( m_luts.isEmpty() )
+        return;
+    /* fold the tables first, so the curve image is only walked once */
+    QVector<quantum_t> lut(QuantumRange+1);
+    for ( int i = 0 ; i <= QuantumRange ; ++i )
+        lut[i] = i;
+    foreach(const std::shared_ptr<const quantum_t>& stage, m_luts)
+        LutBased::compose(lut.data(), stage.get());
+    m_luts.clear();
+
+    Magick::Image curve(m_image);
+    curve.modifyImage();
+    int w = curve.columns();
+    Ordinary::Pixels curve_cache(curve);
+    Magick::PixelPacket *pixels = curve_cache.get(0, 0, w, 1);
+    if ( !pixels ) {
+        dflError(DF_NULL_PIXELS);
+        return;
+    }
+    for ( int x = 0 ; x < w ; ++x ) {
+        pixels[x].red = clamp(lut[pixels[x].red]);
+        pixels[x].green = clamp(lut[pixels[x].green]);
+        pixels[x].blue = clamp(lut[pixels[x].blue]);
+    }
+    curve_cache.sync();
+    m_image = curve;
+}
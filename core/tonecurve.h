@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#ifndef TONECURVE_H
+#define TONECURVE_H
+
+#include <QVector>
+#include <Magick++.h>
+#include <memory>
+
+typedef int quantum_t;
+
+/**
+ * @brief The ToneCurve class is the 65536 entries curve of a photo,
+ * shared between photo copies.
+ *
+ * Look-up tables composed on the curve are only recorded, they are
+ * applied on the curve image when it is asked for, e.g. to display the
+ * curve view. Copies share the image and the recorded tables until one
+ * of them is written.
+ */
+class ToneCurve
+{
+public:
+    ToneCurve();
+    explicit ToneCurve(const Magick::Image& base);
+
+    /**
+     * @brief compose records lut, applied on each channel after the
+     * current curve
+     * @param lut QuantumRange+1 quantum_t entries, must not be modified
+     * afterwards
+     */
+    void compose(std::shared_ptr<const quantum_t> lut);
+
+    const Magick::Image& image() const;
+    Magick::Image& image();
+
+    /**
+     * @brief isSharedWith
+     * @return true if both curves are the same image with the same
+     * tables composed on it, without evaluating them
+     */
+    bool isSharedWith(const ToneCurve& other) const;
+
+private:
+    void evaluate() const;
+
+    mutable Magick::Image m_image;
+    mutable QVector<std::shared_ptr<const quantum_t> > m_luts;
+};
+
+#endif // TONECURVE_H
@@ -5,6 +5,8 @@
 
 #include <QLineF>
 #include <QGenericMatrix>
+#include <cmath>
+#include <cstring>
 
 static inline
 QGenericMatrix<3, 3, double>
@@ -37,12 +39,14 @@ TransformView::TransformView(const Photo &photo, qreal scale, QVector<QPointF> r
     : QObject(parent),
       m_photo(photo),
       m_transform(QTransform()),
+      m_inverse(),
       m_w(m_photo.image().columns()),
       m_h(m_photo.image().rows()),
       m_cache(0),
       m_pixels(0),
       m_error(false),
-      m_hdr(photo.getScale() == Photo::HDR)
+      m_hdr(photo.getScale() == Photo::HDR),
+      m_interpolation(Area)
 {
     QVector<QPointF> reference =ref;
     QVector<QPointF> current = m_photo.getPoints();
@@ -144,7 +148,7 @@ TransformView::TransformView(const Photo &photo, qreal scale, QVector<QPointF> r
         }
     }
     m_transform.scale(1/scale, 1/scale);
-
+    m_inverse = m_transform.inverted();
 }
 
 TransformView::~TransformView()
@@ -155,8 +159,7 @@ TransformView::~TransformView()
 QRectF TransformView::boundingBox()
 {
     QRectF currentBoundingBox(0, 0, m_w, m_h);
-    QTransform trans = m_transform.inverted();
-    return trans.mapRect(currentBoundingBox);
+    return m_inverse.mapRect(currentBoundingBox);
 }
 
 bool TransformView::inError()
@@ -185,8 +188,7 @@ void TransformView::map(qreal x, qreal y, qreal *tx, qreal *ty)
 
 void TransformView::invMap(qreal x, qreal y, qreal *tx, qreal *ty)
 {
-    QTransform trans = m_transform.inverted();
-    trans.map(x,y,tx,ty);
+    m_inverse.map(x,y,tx,ty);
 }
 
 Magick::PixelPacket TransformView::getPixel(int px, int py, bool *definedp)
@@ -254,3 +256,180 @@ Magick::PixelPacket TransformView::getPixel(int px, int py, bool *definedp)
     }
     return pixel;
 }
+
+void TransformView::setInterpolation(TransformView::Interpolation interpolation)
+{
+    m_interpolation = interpolation;
+}
+
+/* kernels of the separable resampler, Radius taps on each side */
+struct BilinearKernel {
+    enum { Radius = 1 };
+    static float weight(float t) {
+        t = fabsf(t);
+        return t < 1 ? 1 - t : 0;
+    }
+};
+
+/* Keys' cubic convolution, a = -0.5 */
+struct BicubicKernel {
+    enum { Radius = 2 };
+    static float weight(float t) {
+        t = fabsf(t);
+        if ( t < 1 )
+            return (1.5f * t - 2.5f) * t * t + 1;
+        if ( t < 2 )
+            return ((-0.5f * t + 2.5f) * t - 4) * t + 2;
+        return 0;
+    }
+};
+
+struct Lanczos3Kernel {
+    enum { Radius = 3 };
+    static float weight(float t) {
+        t = fabsf(t);
+        if ( t < 1e-6f )
+            return 1;
+        if ( t >= 3 )
+            return 0;
+        float pt = M_PI * t;
+        return 3 * sinf(pt) * sinf(pt / 3) / (pt * pt);
+    }
+};
+
+/**
+ * @brief kernelWeights
+ * @param frac position of the sample after the tap Radius-1, in [0,1)
+ * @param weights 2*Radius weights, normalized
+ */
+template<class Kernel>
+static inline void kernelWeights(float frac, float *weights)
+{
+    float sum = 0;
+    for (int k = 0 ; k < 2 * Kernel::Radius ; ++k ) {
+        weights[k] = Kernel::weight(frac - (k - Kernel::Radius + 1));
+        sum += weights[k];
+    }
+    for (int k = 0 ; k < 2 * Kernel::Radius ; ++k )
+        weights[k] /= sum;
+}
+
+/**
+ * @brief resampleRow resamples a row whose first pixel center maps to
+ * (sx, sy), each next one being (dx, dy) further. With a translation the
+ * fractional position, and thus the weights, is the same for all the
+ * pixels of the row and is computed once
+ */
+template<class Kernel>
+static void resampleRow(const Magick::PixelPacket *src, int w, int h, bool hdr,
+                        qreal sx, qreal sy, qreal dx, qreal dy, bool constantWeights,
+                        int count, Magick::PixelPacket *pixels, bool *defined)
+{
+    const int taps = 2 * Kernel::Radius;
+    float wx[taps];
+    float wy[taps];
+    bool weighted = false;
+    for (int i = 0 ; i < count ; ++i, sx += dx, sy += dy ) {
+        if ( sx < 0 || sx >= w || sy < 0 || sy >= h ) {
+            defined[i] = false;
+            memset(&pixels[i], 0, sizeof(pixels[i]));
+            continue;
+        }
+        defined[i] = true;
+        qreal u = sx - .5;
+        qreal v = sy - .5;
+        int iu = floor(u);
+        int iv = floor(v);
+        if ( !weighted || !constantWeights ) {
+            kernelWeights<Kernel>(u - iu, wx);
+            kernelWeights<Kernel>(v - iv, wy);
+            weighted = true;
+        }
+        int x0 = iu - Kernel::Radius + 1;
+        int y0 = iv - Kernel::Radius + 1;
+        float red = 0, green = 0, blue = 0;
+        for (int ky = 0 ; ky < taps ; ++ky ) {
+            const Magick::PixelPacket *line = src + size_t(qBound(0, y0 + ky, h - 1)) * w;
+            float r = 0, g = 0, b = 0;
+            for (int kx = 0 ; kx < taps ; ++kx ) {
+                const Magick::PixelPacket &p = line[qBound(0, x0 + kx, w - 1)];
+                if ( hdr ) {
+                    r += wx[kx] * fromHDR(p.red);
+                    g += wx[kx] * fromHDR(p.green);
+                    b += wx[kx] * fromHDR(p.blue);
+                }
+                else {
+                    r += wx[kx] * p.red;
+                    g += wx[kx] * p.green;
+                    b += wx[kx] * p.blue;
+                }
+            }
+            red += wy[ky] * r;
+            green += wy[ky] * g;
+            blue += wy[ky] * b;
+        }
+        /* bicubic and Lanczos overshoot near the edges of the stars */
+        if ( hdr ) {
+            pixels[i].red = toHDR(qMax(0.f, red));
+            pixels[i].green = toHDR(qMax(0.f, green));
+            pixels[i].blue = toHDR(qMax(0.f, blue));
+        }
+        else {
+            pixels[i].red = clamp<quantum_t>(red);
+            pixels[i].green = clamp<quantum_t>(green);
+            pixels[i].blue = clamp<quantum_t>(blue);
+        }
+    }
+}
+
+void TransformView::getRow(int y, int x0, int count, Magick::PixelPacket *pixels, bool *defined)
+{
+    if ( m_transform.isIdentity() ) {
+        memcpy(pixels, m_pixels + size_t(y) * m_w + x0, count * sizeof(*pixels));
+        for (int i = 0 ; i < count ; ++i )
+            defined[i] = true;
+        return;
+    }
+    if ( m_interpolation == Area ||
+         m_transform.type() == QTransform::TxProject ) {
+        for (int i = 0 ; i < count ; ++i )
+            pixels[i] = getPixel(x0 + i, y, &defined[i]);
+        return;
+    }
+    /* the transform is affine, a step along the row is (m11, m12) */
+    qreal sx, sy;
+    m_transform.map(x0 + .5, y + .5, &sx, &sy);
+    qreal dx = m_transform.m11();
+    qreal dy = m_transform.m12();
+    bool constantWeights = m_transform.type() <= QTransform::TxTranslate;
+    switch (m_interpolation) {
+    default:
+    case Bilinear:
+        resampleRow<BilinearKernel>(m_pixels, m_w, m_h, m_hdr, sx, sy, dx, dy,
+                                    constantWeights, count, pixels, defined);
+        break;
+    case Bicubic:
+        resampleRow<BicubicKernel>(m_pixels, m_w, m_h, m_hdr, sx, sy, dx, dy,
+                                   constantWeights, count, pixels, defined);
+        break;
+    case Lanczos3:
+        resampleRow<Lanczos3Kernel>(m_pixels, m_w, m_h, m_hdr, sx, sy, dx, dy,
+                                    constantWeights, count, pixels, defined);
+        break;
+    }
+}
+
+int TransformView::sourceWidth()
+{
+    return m_w;
+}
+
+int TransformView::sourceHeight()
+{
+    return m_h;
+}
+
+const Magick::PixelPacket *TransformView::sourceRow(int y)
+{
+    return m_pixels + size_t(y) * m_w;
+}
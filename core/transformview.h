@@ -15,6 +15,7 @@ class TransformView : public QObject
 
     Photo m_photo;
     QTransform m_transform;
+    QTransform m_inverse;
     int m_w;
     int m_h;
     Ordinary::Pixels *m_cache;
@@ -22,6 +23,17 @@ class TransformView : public QObject
     bool m_error;
     bool m_hdr;
 
+public:
+    typedef enum {
+        Area,
+        Bilinear,
+        Bicubic,
+        Lanczos3
+    } Interpolation;
+
+private:
+    Interpolation m_interpolation;
+
 public:
     TransformView(const Photo& photo, qreal scale, QVector<QPointF> reference, QObject *parent = 0);
     ~TransformView();
@@ -34,6 +46,28 @@ public:
     void invMap(qreal x, qreal y, qreal *tx, qreal *ty);
     Magick::PixelPacket getPixel(int x, int y, bool *definedp);
 
+    /**
+     * @brief setInterpolation
+     * @param interpolation kernel of getRow(), getPixel() always uses
+     * the area covered by the pixel
+     */
+    void setInterpolation(Interpolation interpolation);
+    /**
+     * @brief getRow resamples count pixels of the row y, from x0. The source
+     * position is stepped along the row rather than mapped for each pixel
+     * @param pixels count pixels
+     * @param defined count flags, false where the pixel maps out of the photo
+     */
+    void getRow(int y, int x0, int count, Magick::PixelPacket *pixels, bool *defined);
+
+    int sourceWidth();
+    int sourceHeight();
+    /**
+     * @brief sourceRow
+     * @return the untransformed pixels of the row y of the photo, once loaded
+     */
+    const Magick::PixelPacket *sourceRow(int y);
+
 };
 
 #endif // TRANSFORMVIEW_H
@@ -0,0 +1,26 @@
+#-------------------------------------------------
+#
+# Benchmarks on synthetic frames, shares everything
+# with darkflow but the entry point
+#
+#-------------------------------------------------
+
+include(darkflow.pro)
+
+TARGET = darkflow-bench
+
+QMAKE_INCDIR += bench
+
+SOURCES -= ui/main.cpp
+SOURCES += \
+    bench/main.cpp \
+    bench/benchmark.cpp \
+    bench/syntheticframes.cpp
+
+HEADERS += \
+    bench/benchmark.h \
+    bench/syntheticframes.h
+
+unix:!macx {
+    INSTALLS -= df_icons df_desktop_entry df_mime_xml
+}
@@ -0,0 +1,26 @@
+#-------------------------------------------------
+#
+# Headless batch runner, shares everything with darkflow
+# but the entry point
+#
+#-------------------------------------------------
+
+include(darkflow.pro)
+
+TARGET = darkflow-cli
+
+QMAKE_INCDIR += cli
+
+SOURCES -= ui/main.cpp
+SOURCES += \
+    cli/main.cpp \
+    cli/batchrunner.cpp \
+    cli/framefarm.cpp
+
+HEADERS += \
+    cli/batchrunner.h \
+    cli/framefarm.h
+
+unix:!macx {
+    INSTALLS -= df_icons df_desktop_entry df_mime_xml
+}
@@ -278,7 +278,20 @@ SOURCES +=\
     operators/opwindowfunction.cpp \
     operators/opcolormap.cpp \
     operators/opstarfinder.cpp \
-    operators/oppixelextrusionmapping.cpp
+    operators/oppixelextrusionmapping.cpp \
+    core/operatorstreamworker.cpp \
+    core/photochannel.cpp \
+    core/resultcache.cpp \
+    core/operatorcacheworker.cpp \
+    core/scheduler.cpp \
+    core/photomemo.cpp \
+    core/resultstore.cpp \
+    core/planarbuffer.cpp \
+    core/tonecurve.cpp \
+    core/threadbudget.cpp \
+    core/cancellation.cpp \
+    core/profiler.cpp \
+    operators/integrationstack.cpp
 
 HEADERS  += \
     ui/aboutdialog.h \
@@ -422,7 +435,21 @@ HEADERS  += \
     operators/opwindowfunction.h \
     operators/opcolormap.h \
     operators/opstarfinder.h \
-    operators/oppixelextrusionmapping.h
+    operators/oppixelextrusionmapping.h \
+    core/operatorstreamworker.h \
+    core/photochannel.h \
+    core/resultcache.h \
+    core/operatorcacheworker.h \
+    core/scheduler.h \
+    core/photomemo.h \
+    core/resultstore.h \
+    core/planarbuffer.h \
+    core/tonecurve.h \
+    core/threadbudget.h \
+    core/cancellation.h \
+    core/profiler.h \
+    core/progresscounter.h \
+    operators/integrationstack.h
 
 
 FORMS    += \
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "integrationstack.h"
+
+/* rejection rounds, and winsorization rounds within each */
+#define DF_STACK_ITERATIONS 10
+
+bool IntegrationStack::isStacked(OpIntegration::RejectionType type)
+{
+    switch(type) {
+    case OpIntegration::Median:
+    case OpIntegration::WinsorizedSigmaClipping:
+    case OpIntegration::LinearFitClipping:
+        return true;
+    default:
+        return false;
+    }
+}
+
+double IntegrationStack::combine(OpIntegration::RejectionType type,
+                                 const float *values, int n,
+                                 qreal upper, qreal lower,
+                                 float *scratch,
+                                 float &low, float &high)
+{
+    low = -FLT_MAX;
+    high = FLT_MAX;
+    if ( n <= 0 )
+        return 0;
+    std::copy(values, values + n, scratch);
+    if ( type == OpIntegration::Median ) {
+        /* nothing is rejected, a partial sort is enough */
+        int half = n / 2;
+        std::nth_element(scratch, scratch + half, scratch + n);
+        if ( n % 2 )
+            return scratch[half];
+        return ( double(scratch[half]) + *std::max_element(scratch, scratch + half) ) / 2.;
+    }
+    std::sort(scratch, scratch + n);
+    int begin = 0;
+    int end = n;
+    if ( type == OpIntegration::LinearFitClipping )
+        linearFitClipping(scratch, begin, end, upper, lower);
+    else
+        winsorizedSigmaClipping(scratch, begin, end, upper, lower);
+    low = scratch[begin];
+    high = scratch[end - 1];
+    return mean(scratch, begin, end);
+}
+
+double IntegrationStack::median(const float *sorted, int begin, int end)
+{
+    int n = end - begin;
+    int half = begin + n / 2;
+    if ( n % 2 )
+        return sorted[half];
+    return ( double(sorted[half - 1]) + sorted[half] ) / 2.;
+}
+
+double IntegrationStack::mean(const float *sorted, int begin, int end)
+{
+    double sum = 0;
+    for (int i = begin ; i < end ; ++i )
+        sum += sorted[i];
+    return sum / (end - begin);
+}
+
+/**
+ * @brief IntegrationStack::winsorizedSigmaClipping rejects the values
+ * away from the median by more than the given multiples of a deviation
+ * robust to the outliers: the one of the stack with its tails clamped to
+ * 1.5 sigma, corrected for that clamping
+ */
+void IntegrationStack::winsorizedSigmaClipping(const float *sorted, int &begin, int &end,
+                                               qreal upper, qreal lower)
+{
+    for (int iteration = 0 ; iteration < DF_STACK_ITERATIONS && end - begin >= 3 ; ++iteration ) {
+        int n = end - begin;
+        double m = median(sorted, begin, end);
+        double mu = mean(sorted, begin, end);
+        double sigma = 0;
+        for (int i = begin ; i < end ; ++i )
+            sigma += (sorted[i] - mu) * (sorted[i] - mu);
+        sigma = sqrt(sigma / n);
+        for (int round = 0 ; round < DF_STACK_ITERATIONS && sigma > 0 ; ++round ) {
+            double lo = m - 1.5 * sigma;
+            double hi = m + 1.5 * sigma;
+            double sum = 0, sum2 = 0;
+            for (int i = begin ; i < end ; ++i ) {
+                double v = qBound(lo, double(sorted[i]), hi);
+                sum += v;
+                sum2 += v * v;
+            }
+            double wmu = sum / n;
+            double wsigma = 1.134 * sqrt(qMax(0., sum2 / n - wmu * wmu));
+            bool converged = fabs(wsigma - sigma) <= 5e-4 * sigma;
+            sigma = wsigma;
+            if ( converged )
+                break;
+        }
+        int newBegin = std::lower_bound(sorted + begin, sorted + end, float(m - lower * sigma)) - sorted;
+        int newEnd = std::upper_bound(sorted + begin, sorted + end, float(m + upper * sigma)) - sorted;
+        if ( newEnd <= newBegin ||
+             ( newBegin == begin && newEnd == end ) )
+            break;
+        begin = newBegin;
+        end = newEnd;
+    }
+}
+
+/**
+ * @brief IntegrationStack::linearFitClipping fits a line to the sorted
+ * stack and rejects the ends farther from it than the given multiples of
+ * the mean absolute deviation. Suited to large stacks with a sky gradient
+ * changing along the session
+ */
+void IntegrationStack::linearFitClipping(const float *sorted, int &begin, int &end,
+                                         qreal upper, qreal lower)
+{
+    for (int iteration = 0 ; iteration < DF_STACK_ITERATIONS && end - begin >= 3 ; ++iteration ) {
+        double n = end - begin;
+        double sx = n * (n - 1) / 2.;
+        double sxx = (n - 1) * n * (2 * n - 1) / 6.;
+        double sy = 0, sxy = 0;
+        for (int i = begin ; i < end ; ++i ) {
+            sy += sorted[i];
+            sxy += double(i - begin) * sorted[i];
+        }
+        double slope = ( n * sxy - sx * sy ) / ( n * sxx - sx * sx );
+        double intercept = ( sy - slope * sx ) / n;
+        double sigma = 0;
+        for (int i = begin ; i < end ; ++i )
+            sigma += fabs(sorted[i] - (intercept + slope * (i - begin)));
+        sigma /= n;
+        int newBegin = begin;
+        int newEnd = end;
+        while ( newBegin < newEnd &&
+                sorted[newBegin] < intercept + slope * (newBegin - begin) - lower * sigma )
+            ++newBegin;
+        while ( newEnd > newBegin &&
+                sorted[newEnd - 1] > intercept + slope * (newEnd - 1 - begin) + upper * sigma )
+            --newEnd;
+        if ( newEnd <= newBegin ||
+             ( newBegin == begin && newEnd == end ) )
+            break;
+        begin = newBegin;
+        end = newEnd;
+    }
+}
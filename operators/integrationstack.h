@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2006-2016, Guillaume Gimenez <guillaume@blackmilk.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of G.Gimenez nor the names of its contributors may
+ *       be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL G.Gimenez BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors:
+ *     * Guillaume Gimenez <guillaume@blackmilk.fr>
+ *
+ */
+#ifndef INTEGRATIONSTACK_H
+#define INTEGRATIONSTACK_H
+
+#include <QtGlobal>
+#include "opintegration.h"
+
+/**
+ * @brief The IntegrationStack class combines the values a sub-pixel takes
+ * in every frame, gathered contiguously by the tiled integration. Unlike the
+ * frame by frame integration, the whole stack is at hand, so the rejections
+ * can be based on its order statistics
+ */
+class IntegrationStack
+{
+public:
+    /**
+     * @brief isStacked
+     * @return true if the rejection needs the whole stack of each sub-pixel
+     */
+    static bool isStacked(OpIntegration::RejectionType type);
+
+    /**
+     * @brief combine
+     * @param type Median, WinsorizedSigmaClipping or LinearFitClipping
+     * @param values the stack, left untouched
+     * @param n size of the stack
+     * @param upper sigma multiplier of the upper bound
+     * @param lower sigma multiplier of the lower bound
+     * @param scratch n floats
+     * @param low the values below are rejected
+     * @param high the values above are rejected
+     * @return the combined value, 0 if the stack is empty
+     */
+    static double combine(OpIntegration::RejectionType type,
+                          const float *values, int n,
+                          qreal upper, qreal lower,
+                          float *scratch,
+                          float &low, float &high);
+
+private:
+    static double median(const float *sorted, int begin, int end);
+    static double mean(const float *sorted, int begin, int end);
+    static void winsorizedSigmaClipping(const float *sorted, int &begin, int &end,
+                                        qreal upper, qreal lower);
+    static void linearFitClipping(const float *sorted, int &begin, int &end,
+                                  qreal upper, qreal lower);
+};
+
+#endif // INTEGRATIONSTACK_H
@@ -43,6 +43,7 @@ public:
     OpAdaptiveThreshold(Process *parent);
     OpAdaptiveThreshold *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 private:
     OperatorParameterSlider *m_width;
     OperatorParameterSlider *m_height;
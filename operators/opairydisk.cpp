@@ -89,10 +89,11 @@ private slots:
             double *pixels = new double[w*h*3];
             dfl_block double max = 0;
             int sq_p = m_precision*m_precision;
+            setProgress(0, 2*h);
             dfl_parallel_for(y, 0, h, 4, (), {
                 if (aborted())
                     continue;
-                emit progress(y/2, h);
+                advanceProgress();
                 for (int x = 0 ; x < w ; ++x ) {
                     double rgb[3] = {0, 0, 0};
                     for ( int jy = 0 ; jy < m_precision ; ++jy ) {
@@ -124,7 +125,7 @@ private slots:
             dfl_parallel_for(y, 0, h, 4, (image), {
                 if (aborted())
                     continue;
-                emit progress(h/2+y/2, h);
+                advanceProgress();
                 Magick::PixelPacket *pxl = cache->get(0,y,w,1);
                 if ( m_error || !pxl ) {
                     if ( !m_error )
@@ -43,6 +43,7 @@ public:
     OpBlur(Process *parent);
     OpBlur *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 private:
     OperatorParameterSlider *m_radius;
     OperatorParameterSlider *m_sigma;
@@ -77,3 +77,18 @@ OperatorWorker *OpChannelMixer::newWorker()
 {
     return new WorkerChannelMixer(m_r->value(), m_g->value(), m_b->value(), m_thread, this);
 }
+
+Algorithm *OpChannelMixer::getAlgorithm() const
+{
+    return new ChannelMixer(m_r->value(), m_g->value(), m_b->value());
+}
+
+void OpChannelMixer::releaseAlgorithm(Algorithm *algo) const
+{
+    delete algo;
+}
+
+bool OpChannelMixer::isStreamable() const
+{
+    return true;
+}
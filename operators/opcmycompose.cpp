@@ -134,7 +134,7 @@ public:
                 photo.setTag(TAG_NAME, "LCMY Composition");
                 Ordinary::Pixels iPhoto_cache(photo.image());
                 Magick::PixelPacket *pxl = iPhoto_cache.get(0, 0, w, h);
-                dfl_block int line = 0;
+                emitProgress(i, photo_count, 0, h);
                 bool hdrLuminance = pLuminance.getScale() == Photo::HDR;
                 bool hdrCyan = pCyan.getScale() == Photo::HDR;
                 bool hdrMagenta = pMagenta.getScale() == Photo::HDR;
@@ -202,10 +202,7 @@ public:
                             pxl[y*w+x].blue=clamp<quantum_t>(DF_ROUND(rgb[2]));
                         }
                     }
-                    dfl_critical_section(
-                    {
-                        emitProgress(i, photo_count,line++, h);
-                    });
+                    advanceProgress();
                 });
                 iPhoto_cache.sync();
                 if (m_outputHDR)
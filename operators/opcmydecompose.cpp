@@ -71,7 +71,7 @@ public:
                 std::shared_ptr<Ordinary::Pixels> iLuminance_cache(new Ordinary::Pixels(iLuminance));
                 int w = srcImage.columns();
                 int h = srcImage.rows();
-                dfl_block int line = 0;
+                emitProgress(p, c, 0, h);
                 dfl_parallel_for(y, 0, h, 4, (srcImage, iCyan, iMagenta, iYellow, iLuminance), {
                     const Magick::PixelPacket *src = src_cache->getConst(0, y, w, 1);
                     Magick::PixelPacket *pxl_Cyan = iCyan_cache->get(0, y, w, 1);
@@ -99,9 +99,7 @@ public:
                     iMagenta_cache->sync();
                     iYellow_cache->sync();
                     iLuminance_cache->sync();
-                    dfl_critical_section({
-                        emitProgress(p, c, line++, h);
-                    });
+                    advanceProgress();
                 });
                 outputPush(0, pLuminance);
                 outputPush(1, pCyan);
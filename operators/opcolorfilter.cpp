@@ -76,3 +76,18 @@ OperatorWorker *OpColorFilter::newWorker()
 {
     return new WorkerColorFilter(m_r->value(), m_g->value(), m_b->value(), m_thread, this);
 }
+
+Algorithm *OpColorFilter::getAlgorithm() const
+{
+    return new ColorFilter(m_r->value(), m_g->value(), m_b->value());
+}
+
+void OpColorFilter::releaseAlgorithm(Algorithm *algo) const
+{
+    delete algo;
+}
+
+bool OpColorFilter::isStreamable() const
+{
+    return true;
+}
@@ -43,6 +43,10 @@ public:
     OpColorFilter(Process *parent);
     OpColorFilter *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
+    Algorithm *getAlgorithm() const;
+    void releaseAlgorithm(Algorithm *algo) const;
+    bool isStreamable() const;
 private:
     OperatorParameterSlider *m_r;
     OperatorParameterSlider *m_g;
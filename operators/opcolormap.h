@@ -41,6 +41,7 @@ public:
     OpColorMap(Process *parent);
     OpColorMap *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 };
 
 #endif // OPCOLORMAP_H
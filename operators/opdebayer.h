@@ -55,6 +55,7 @@ public:
     OpDebayer(Process *parent);
     OpDebayer *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 
 public slots:
     void setDebayer(int v);
@@ -83,3 +83,20 @@ OperatorWorker *OpDesaturateShadows::newWorker()
                            m_saturation->value(),
                            m_thread, this);
 }
+
+Algorithm *OpDesaturateShadows::getAlgorithm() const
+{
+    return new DesaturateShadows(m_highlightLimit->value(),
+                                 m_range->value(),
+                                 m_saturation->value());
+}
+
+void OpDesaturateShadows::releaseAlgorithm(Algorithm *algo) const
+{
+    delete algo;
+}
+
+bool OpDesaturateShadows::isStreamable() const
+{
+    return true;
+}
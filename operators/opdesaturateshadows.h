@@ -43,6 +43,10 @@ public:
     OpDesaturateShadows(Process *parent);
     OpDesaturateShadows *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
+    Algorithm *getAlgorithm() const;
+    void releaseAlgorithm(Algorithm *algo) const;
+    bool isStreamable() const;
 private:
     OperatorParameterSlider *m_highlightLimit;
     OperatorParameterSlider *m_range;
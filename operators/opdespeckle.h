@@ -41,6 +41,7 @@ public:
     OpDespeckle(Process *parent);
     OpDespeckle *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 };
 
 #endif // OPDESPECKLE_H
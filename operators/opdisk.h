@@ -44,6 +44,7 @@ public:
     OpDisk(Process *parent);
     OpDisk *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 
 private slots:
     void selectColor(int v);
@@ -74,16 +74,24 @@ public:
             Photo sign(photo);
             ATrousWaveletTransform dwt(photo, wavelet, order);
             for (int n = 0 ; n < m_planes ; ++n) {
-                outputPush(n, dwt.transform(n, m_planes,
+                Photo plane = dwt.transform(n, m_planes,
                                             m_outputHDR
                                             ? Photo::HDR
                                             : Photo::Linear,
-                                            sign));
+                                            sign);
+                if ( aborted() )
+                    break;
+                outputPush(n, plane);
                 outputPush(m_planes, sign);
                 emitProgress(i, s, n, m_planes);
             }
+            if ( aborted() )
+                break;
         }
-        emitSuccess();
+        if ( aborted() )
+            emitFailure();
+        else
+            emitSuccess();
     }
 };
 
@@ -41,6 +41,7 @@ public:
     OpEnhance(Process *parent);
     OpEnhance *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 };
 
 #endif // OPENHANCE_H
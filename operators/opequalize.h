@@ -40,6 +40,7 @@ public:
     OpEqualize(Process *parent);
     OpEqualize *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 };
 
 #endif // OPEQUALIZE_H
@@ -58,7 +58,7 @@ private slots:
                 unsigned w = image.columns();
                 unsigned h = image.rows();
                 for (unsigned y = 0 ; y < h ; ++y) {
-                    emit progress(y, h);
+                    setProgress(y, h);
                     if ( aborted() ) {
                         emitFailure();
                         return;
@@ -73,3 +73,18 @@ OperatorWorker *OpExposure::newWorker()
 {
     return new WorkerExposure(m_value->value(), m_thread, this);
 }
+
+Algorithm *OpExposure::getAlgorithm() const
+{
+    return new Exposure(m_value->value());
+}
+
+void OpExposure::releaseAlgorithm(Algorithm *algo) const
+{
+    delete algo;
+}
+
+bool OpExposure::isStreamable() const
+{
+    return true;
+}
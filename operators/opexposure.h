@@ -43,6 +43,10 @@ public:
     OpExposure(Process *parent);
     OpExposure *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
+    Algorithm *getAlgorithm() const;
+    void releaseAlgorithm(Algorithm *algo) const;
+    bool isStreamable() const;
 
 signals:
 
@@ -34,7 +34,9 @@
 #include "operatoroutput.h"
 #include "operatorparameterdropdown.h"
 #include "photo.h"
+#include "planarbuffer.h"
 #include <Magick++.h>
+#include <cstring>
 #include "algorithm.h"
 #include "hdr.h"
 #include "console.h"
@@ -53,29 +55,24 @@ public:
     void play_analyseSources() {
         Q_ASSERT(m_inputs.count() == 2);
         foreach(Photo photo, m_inputs[1]) {
-            bool hdr = photo.getScale() == Photo::HDR;
             try  {
-                Magick::Image& image = photo.image();
-                Ordinary::Pixels pixels_cache(image);
-                int w = image.columns();
-                int h = image.rows();
+                std::shared_ptr<const PlanarBuffer> flatfield = photo.planar();
+                int w = flatfield->width();
+                int h = flatfield->height();
                 Triplet<real> max;
                 for ( int y = 0 ; y < h ; ++ y) {
-                    const Magick::PixelPacket * pixels = pixels_cache.getConst(0, y, w, 1);
+                    const float *red = flatfield->row(PlanarBuffer::Red, y);
+                    const float *green = flatfield->row(PlanarBuffer::Green, y);
+                    const float *blue = flatfield->row(PlanarBuffer::Blue, y);
                     for ( int x = 0 ; x < w ; ++x ) {
-                        if ( pixels[x].red > max.red )
-                            max.red = pixels[x].red;
-                        if ( pixels[x].green > max.green )
-                            max.green = pixels[x].green;
-                        if ( pixels[x].blue > max.blue )
-                            max.blue = pixels[x].blue;
+                        if ( red[x] > max.red )
+                            max.red = red[x];
+                        if ( green[x] > max.green )
+                            max.green = green[x];
+                        if ( blue[x] > max.blue )
+                            max.blue = blue[x];
                     }
                 }
-                if ( hdr ) {
-                    max.red = fromHDR(max.red);
-                    max.green = fromHDR(max.green);
-                    max.blue = fromHDR(max.blue);
-                }
                 m_max.push_back(max);
             }
             catch (std::exception &e) {
@@ -84,110 +81,74 @@ public:
             }
         }
     }
-    template<typename PIXEL>
-    void correct(Magick::Image &image, bool imageIsHDR,
-                 Magick::Image& flatfield, bool flatfieldIsHDR,
-                 Magick::Image& overflow,
+    void correct(Photo &photo,
+                 const Photo& flatfieldPhoto,
+                 Photo& overflowPhoto,
                  Triplet<real> & max,
                  int p,
                  int c) {
-        int w = image.columns();
-        int h = image.rows();
-        int f_w = flatfield.columns();
-        int f_h = flatfield.rows();
-        if ( w != f_w || h != f_h ) {
+        std::shared_ptr<const PlanarBuffer> src = photo.planar();
+        std::shared_ptr<const PlanarBuffer> flatfield = flatfieldPhoto.planar();
+        int w = src->width();
+        int h = src->height();
+        if ( w != flatfield->width() || h != flatfield->height() ) {
             dflError("size mismatch");
             return;
         }
-        Magick::Image srcImage(image);
-        ResetImage(image);
-        ResetImage(overflow);
-        std::shared_ptr<Ordinary::Pixels> src_cache(new Ordinary::Pixels(srcImage));
-        std::shared_ptr<Ordinary::Pixels> image_cache(new Ordinary::Pixels(image));
-        std::shared_ptr<Ordinary::Pixels> flatfield_cache(new Ordinary::Pixels(flatfield));
-        std::shared_ptr<Ordinary::Pixels> overflow_cache(new Ordinary::Pixels(overflow));
-        dfl_block int line=0;
-        dfl_parallel_for(y, 0, h, 4, (srcImage, image, flatfield, overflow), {
-            Magick::PixelPacket *image_pixels = image_cache->get(0, y, w, 1);
-            Magick::PixelPacket *overflow_pixels = overflow_cache->get(0, y, w, 1);
-            const Magick::PixelPacket *flatfield_pixels = flatfield_cache->getConst(0, y, w, 1);
-            const Magick::PixelPacket *src = src_cache->getConst(0, y, w, 1);
-            if ( m_error || !image_pixels || !overflow_pixels || !flatfield_pixels || !src ) {
-                if ( !m_error )
-                    dflError(DF_NULL_PIXELS);
+        std::shared_ptr<PlanarBuffer> image(new PlanarBuffer(w, h));
+        std::shared_ptr<PlanarBuffer> overflow(new PlanarBuffer(w, h));
+        const real ceiling = m_outputHDR ? fromHDR(QuantumRange) : QuantumRange;
+        emitProgress(p, c, 0, h);
+        dfl_parallel_for(y, 0, h, 4, (), {
+            if ( m_error )
                 continue;
-            }
-
+            const float *src_red = src->row(PlanarBuffer::Red, y);
+            const float *src_green = src->row(PlanarBuffer::Green, y);
+            const float *src_blue = src->row(PlanarBuffer::Blue, y);
+            const float *ff_red = flatfield->row(PlanarBuffer::Red, y);
+            const float *ff_green = flatfield->row(PlanarBuffer::Green, y);
+            const float *ff_blue = flatfield->row(PlanarBuffer::Blue, y);
+            float *red = image->row(PlanarBuffer::Red, y);
+            float *green = image->row(PlanarBuffer::Green, y);
+            float *blue = image->row(PlanarBuffer::Blue, y);
+            float *overflow_pixels = overflow->row(PlanarBuffer::Red, y);
             for ( int x = 0 ; x < w ; ++x ) {
-                Triplet<PIXEL> ff;
+                Triplet<real> ff(ff_red[x], ff_green[x], ff_blue[x]);
                 bool singularity = false;
-                if ( flatfield_pixels[x].red )
-                    ff.red = flatfield_pixels[x].red;
-                else {
-                    //continue;
+                if ( !ff.red ) {
                     ff.red = 1;
                     singularity = true;
                 }
-                if ( flatfield_pixels[x].green )
-                    ff.green = flatfield_pixels[x].green;
-                else {
-                    //continue;
+                if ( !ff.green ) {
                     ff.green = 1;
                     singularity = true;
                 }
-                if ( flatfield_pixels[x].blue )
-                    ff.blue = flatfield_pixels[x].blue;
-                else {
-                    //continue;
+                if ( !ff.blue ) {
                     ff.blue = 1;
                     singularity = true;
                 }
-                if ( flatfieldIsHDR ) {
-                    ff.red = fromHDR(ff.red);
-                    ff.green = fromHDR(ff.green);
-                    ff.blue = fromHDR(ff.blue);
-                }
-                PIXEL r = src[x].red;
-                PIXEL g = src[x].green;
-                PIXEL b = src[x].blue;
-                if ( imageIsHDR ) {
-                    r = fromHDR(r);
-                    g = fromHDR(g);
-                    b = fromHDR(b);
-                }
-                r = r * max.red  / ff.red;
-                g = g * max.green / ff.green;
-                b = b * max.blue / ff.blue;
-                overflow_pixels[x].red = overflow_pixels[x].green = overflow_pixels[x].blue =
+                real r = src_red[x] * max.red / ff.red;
+                real g = src_green[x] * max.green / ff.green;
+                real b = src_blue[x] * max.blue / ff.blue;
+                overflow_pixels[x] =
                         ( singularity || r > QuantumRange || g > QuantumRange || b > QuantumRange )
                         ? QuantumRange
                         : 0;
-                if ( m_outputHDR ) {
-                    image_pixels[x].red =
-                            clamp<quantum_t>(toHDR(r));
-                    image_pixels[x].green =
-                            clamp<quantum_t>(toHDR(g));
-                    image_pixels[x].blue =
-                            clamp<quantum_t>(toHDR(b));
-                }
-                else {
-                    image_pixels[x].red =
-                            clamp<quantum_t>(r);
-                    image_pixels[x].green =
-                            clamp<quantum_t>(g);
-                    image_pixels[x].blue =
-                            clamp<quantum_t>(b);
-                }
+                red[x] = clamp<real>(r, 0, ceiling);
+                green[x] = clamp<real>(g, 0, ceiling);
+                blue[x] = clamp<real>(b, 0, ceiling);
             }
-            dfl_critical_section(
-            {
-                if ( line % 100 == 0 )
-                    emitProgress(p, c, line, h);
-                ++line;
-            });
-            image_cache->sync();
-            overflow_cache->sync();
+            memcpy(overflow->row(PlanarBuffer::Green, y), overflow_pixels, w * sizeof(float));
+            memcpy(overflow->row(PlanarBuffer::Blue, y), overflow_pixels, w * sizeof(float));
+            advanceProgress();
         });
+        if ( m_outputHDR )
+            photo.setScale(Photo::HDR);
+        else if ( photo.getScale() == Photo::HDR )
+            photo.setScale(Photo::Linear);
+        photo.setPlanar(image);
+        overflowPhoto.setScale(Photo::Linear);
+        overflowPhoto.setPlanar(overflow);
     }
 
     void play() {
@@ -204,28 +165,13 @@ public:
                     continue;
                 try {
                     Photo overflow(photo);
-                    if (photo.getScale() == Photo::HDR ||
-                        flatfield.getScale() == Photo::HDR )
-                        correct<real>(photo.image(), photo.getScale() == Photo::HDR,
-                                      flatfield.image(), flatfield.getScale() == Photo::HDR,
-                                      overflow.image(),
-                                      m_max[source_flatfield_idx],
-                                      n, n_photos);
-                    else
-                        correct<quantum_t>(photo.image(), photo.getScale() == Photo::HDR,
-                                           flatfield.image(), flatfield.getScale() == Photo::HDR,
-                                           overflow.image(),
-                                           m_max[source_flatfield_idx],
-                                           n, n_photos);
-                    if ( m_outputHDR )
-                        photo.setScale(Photo::HDR);
-                    else if ( photo.getScale() == Photo::HDR )
-                        photo.setScale(Photo::Linear);
-                    overflow.setScale(Photo::Linear);
+                    correct(photo, flatfield, overflow,
+                            m_max[source_flatfield_idx],
+                            n, n_photos);
                     outputPush(0, photo);
                     outputPush(1, overflow);
                     ++n;
-                    emit progress(n, n_photos);
+                    setProgress(n, n_photos);
                 }
                 catch (std::exception &e) {
                     setError(flatfield, e.what());
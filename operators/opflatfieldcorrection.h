@@ -44,6 +44,7 @@ public:
     OpFlatFieldCorrection *newInstance();
 
     OperatorWorker *newWorker();
+    bool isShardable() const { return true; }
 
 signals:
 
@@ -41,6 +41,7 @@ public:
     OpFlip(Process *parent);
     OpFlip *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 };
 
 #endif // OPFLIP_H
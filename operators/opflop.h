@@ -41,6 +41,7 @@ public:
     OpFlop(Process *parent);
     OpFlop *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 };
 
 #endif // OPFLOP_H
@@ -43,6 +43,7 @@ public:
     OpGradientEvaluation(Process *parent);
     OpGradientEvaluation *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 private:
     OperatorParameterSlider *m_radius;
     OperatorParameterSlider *m_altitude;
@@ -79,6 +79,21 @@ OperatorWorker *OpHDR::newWorker()
     return new WorkerHDR(m_revert, m_thread, this);
 }
 
+Algorithm *OpHDR::getAlgorithm() const
+{
+    return new HDR(m_revert);
+}
+
+void OpHDR::releaseAlgorithm(Algorithm *algo) const
+{
+    delete algo;
+}
+
+bool OpHDR::isStreamable() const
+{
+    return true;
+}
+
 void OpHDR::revert(int v)
 {
     if ( m_revert != !!v ) {
@@ -44,6 +44,10 @@ public:
 
     OpHDR *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
+    Algorithm *getAlgorithm() const;
+    void releaseAlgorithm(Algorithm *algo) const;
+    bool isStreamable() const;
 
 signals:
 
@@ -44,6 +44,7 @@ public:
     OpHotPixels(Process *parent);
     OpHotPixels *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 private slots:
     void selectAggressive(int v);
     void selectNaive(int v);
@@ -121,6 +121,21 @@ OperatorWorker *OpIGamma::newWorker()
     return new WorkerIGamma(m_gamma->value(), 1./m_dynamicRange->value(), m_revert, m_thread, this);
 }
 
+Algorithm *OpIGamma::getAlgorithm() const
+{
+    return new iGamma(m_gamma->value(), 1./m_dynamicRange->value(), m_revert);
+}
+
+void OpIGamma::releaseAlgorithm(Algorithm *algo) const
+{
+    delete algo;
+}
+
+bool OpIGamma::isStreamable() const
+{
+    return true;
+}
+
 void OpIGamma::revert(int v)
 {
     if ( m_revert != !!v ) {
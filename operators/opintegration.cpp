@@ -41,13 +41,22 @@ static const char *RejectionTypeStr[] = {
     QT_TRANSLATE_NOOP("OpIntegration", "None"),
     QT_TRANSLATE_NOOP("OpIntegration", "Min/Max"),
     QT_TRANSLATE_NOOP("OpIntegration", "Average Deviation"),
-    QT_TRANSLATE_NOOP("OpIntegration", "Sigma clipping")
+    QT_TRANSLATE_NOOP("OpIntegration", "Sigma clipping"),
+    QT_TRANSLATE_NOOP("OpIntegration", "Median"),
+    QT_TRANSLATE_NOOP("OpIntegration", "Winsorized sigma clipping"),
+    QT_TRANSLATE_NOOP("OpIntegration", "Linear fit clipping")
 };
 static const char *NormalizationTypeStr[] = {
     QT_TRANSLATE_NOOP("OpIntegration", "None"),
     QT_TRANSLATE_NOOP("OpIntegration", "Highest Value"),
     QT_TRANSLATE_NOOP("OpIntegration", "Custom")
 };
+static const char *InterpolationStr[] = {
+    QT_TRANSLATE_NOOP("OpIntegration", "Area"),
+    QT_TRANSLATE_NOOP("OpIntegration", "Bilinear"),
+    QT_TRANSLATE_NOOP("OpIntegration", "Bicubic"),
+    QT_TRANSLATE_NOOP("OpIntegration", "Lanczos3")
+};
 
 using Magick::Quantum;
 
@@ -62,7 +71,12 @@ OpIntegration::OpIntegration(Process *parent) :
     m_customNormalization(new OperatorParameterSlider("normalizationValue", tr("Custom Norm."), tr("Integration Custom Normalization"), Slider::ExposureValue, Slider::Logarithmic, Slider::Real, 1, 1<<4, 1, 1./QuantumRange, QuantumRange, Slider::FilterExposureFromOne, this)),
     m_outputHDR(new OperatorParameterDropDown("outputHDR", tr("Output HDR"), this, SLOT(setOutputHDR(int)))),
     m_outputHDRValue(false),
-    m_scale(new OperatorParameterSlider("scale", tr("Scale"), tr("Integration scale"), Slider::Value, Slider::Logarithmic, Slider::Real, 1./4., 4, 1, 1./4., 4., Slider::FilterPercent, this))
+    m_scale(new OperatorParameterSlider("scale", tr("Scale"), tr("Integration scale"), Slider::Value, Slider::Logarithmic, Slider::Real, 1./4., 4, 1, 1./4., 4., Slider::FilterPercent, this)),
+    m_interpolation(new OperatorParameterDropDown("interpolation", tr("Interpolation"), this, SLOT(setInterpolation(int)))),
+    m_interpolationValue(TransformView::Area),
+    m_drizzle(new OperatorParameterDropDown("drizzle", tr("Drizzle"), this, SLOT(setDrizzle(int)))),
+    m_drizzleValue(false),
+    m_pixfrac(new OperatorParameterSlider("pixfrac", tr("Drop size"), tr("Drizzle drop size"), Slider::Percent, Slider::Linear, Slider::Real, .1, 1, .7, .01, 1, Slider::FilterPercent, this))
 {
     addInput(new OperatorInput(tr("Images"), OperatorInput::Set, this));
     addOutput(new OperatorOutput(tr("Integrated Image"), this));
@@ -72,6 +86,9 @@ OpIntegration::OpIntegration(Process *parent) :
     m_rejectionTypeDropDown->addOption(DF_TR_AND_C(RejectionTypeStr[MinMax]), MinMax);
     m_rejectionTypeDropDown->addOption(DF_TR_AND_C(RejectionTypeStr[AverageDeviation]), AverageDeviation);
     m_rejectionTypeDropDown->addOption(DF_TR_AND_C(RejectionTypeStr[SigmaClipping]), SigmaClipping);
+    m_rejectionTypeDropDown->addOption(DF_TR_AND_C(RejectionTypeStr[Median]), Median);
+    m_rejectionTypeDropDown->addOption(DF_TR_AND_C(RejectionTypeStr[WinsorizedSigmaClipping]), WinsorizedSigmaClipping);
+    m_rejectionTypeDropDown->addOption(DF_TR_AND_C(RejectionTypeStr[LinearFitClipping]), LinearFitClipping);
 
     m_normalizationTypeDropDown->addOption(DF_TR_AND_C(NormalizationTypeStr[NoNormalization]), NoNormalization, true);
     m_normalizationTypeDropDown->addOption(DF_TR_AND_C(NormalizationTypeStr[HighestValue]), HighestValue);
@@ -80,12 +97,23 @@ OpIntegration::OpIntegration(Process *parent) :
     m_outputHDR->addOption(DF_TR_AND_C("No"), false, true);
     m_outputHDR->addOption(DF_TR_AND_C("Yes"), true);
 
+    m_interpolation->addOption(DF_TR_AND_C(InterpolationStr[TransformView::Area]), TransformView::Area, true);
+    m_interpolation->addOption(DF_TR_AND_C(InterpolationStr[TransformView::Bilinear]), TransformView::Bilinear);
+    m_interpolation->addOption(DF_TR_AND_C(InterpolationStr[TransformView::Bicubic]), TransformView::Bicubic);
+    m_interpolation->addOption(DF_TR_AND_C(InterpolationStr[TransformView::Lanczos3]), TransformView::Lanczos3);
+
+    m_drizzle->addOption(DF_TR_AND_C("No"), false, true);
+    m_drizzle->addOption(DF_TR_AND_C("Yes"), true);
+
     addParameter(m_rejectionTypeDropDown);
     addParameter(m_upper);
     addParameter(m_lower);
     addParameter(m_normalizationTypeDropDown);
     addParameter(m_customNormalization);
     addParameter(m_scale);
+    addParameter(m_interpolation);
+    addParameter(m_drizzle);
+    addParameter(m_pixfrac);
     addParameter(m_outputHDR);
 }
 
@@ -103,6 +131,9 @@ OperatorWorker *OpIntegration::newWorker()
                                  m_customNormalization->value(),
                                  m_outputHDRValue,
                                  m_scale->value(),
+                                 m_interpolationValue,
+                                 m_drizzleValue,
+                                 m_pixfrac->value(),
                                  m_thread, this);
 }
 
@@ -129,3 +160,19 @@ void OpIntegration::setOutputHDR(int type)
         setOutOfDate();
     }
 }
+
+void OpIntegration::setInterpolation(int type)
+{
+    if ( m_interpolationValue != type ) {
+        m_interpolationValue = TransformView::Interpolation(type);
+        setOutOfDate();
+    }
+}
+
+void OpIntegration::setDrizzle(int type)
+{
+    if ( m_drizzleValue != !!type ) {
+        m_drizzleValue = !!type;
+        setOutOfDate();
+    }
+}
@@ -32,6 +32,7 @@
 #define OPINTEGRATION_H
 
 #include "operator.h"
+#include "transformview.h"
 #include <QObject>
 
 class OperatorParameterSlider;
@@ -46,6 +47,9 @@ public:
         MinMax,
         AverageDeviation,
         SigmaClipping,
+        Median,
+        WinsorizedSigmaClipping,
+        LinearFitClipping,
     } RejectionType;
 
     typedef enum {
@@ -64,6 +68,8 @@ public slots:
 
     void setNormalizationType(int type);
     void setOutputHDR(int type);
+    void setInterpolation(int type);
+    void setDrizzle(int type);
 
 private:
     RejectionType m_rejectionType;
@@ -76,6 +82,11 @@ private:
     OperatorParameterDropDown *m_outputHDR;
     bool m_outputHDRValue;
     OperatorParameterSlider *m_scale;
+    OperatorParameterDropDown *m_interpolation;
+    TransformView::Interpolation m_interpolationValue;
+    OperatorParameterDropDown *m_drizzle;
+    bool m_drizzleValue;
+    OperatorParameterSlider *m_pixfrac;
 
 };
 
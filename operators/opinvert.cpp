@@ -66,3 +66,18 @@ OperatorWorker *OpInvert::newWorker()
 {
     return new WorkerInvert(m_thread, this);
 }
+
+Algorithm *OpInvert::getAlgorithm() const
+{
+    return new Invert();
+}
+
+void OpInvert::releaseAlgorithm(Algorithm *algo) const
+{
+    delete algo;
+}
+
+bool OpInvert::isStreamable() const
+{
+    return true;
+}
@@ -42,6 +42,10 @@ public:
 
     OpInvert *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
+    Algorithm *getAlgorithm() const;
+    void releaseAlgorithm(Algorithm *algo) const;
+    bool isStreamable() const;
 };
 
 #endif // OPINVERT_H
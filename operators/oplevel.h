@@ -43,6 +43,7 @@ public:
     OpLevel(Process *parent);
     OpLevel *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 private:
     OperatorParameterSlider *m_blackPoint;
     OperatorParameterSlider *m_whitePoint;
@@ -41,6 +41,7 @@ public:
     OpMicroContrasts(Process *parent);
     OpMicroContrasts *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 };
 
 #endif // OPMICROCONTRASTS_H
@@ -43,6 +43,7 @@ public:
     OpModulate(Process *parent);
     OpModulate *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 
 signals:
 
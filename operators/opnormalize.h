@@ -41,6 +41,7 @@ public:
     OpNormalize(Process *parent);
     OpNormalize *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 };
 
 #endif // OPNORMALIZE_H
@@ -42,6 +42,7 @@ public:
 
     OpPixelExtrusionMapping *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 };
 
 #endif // OPISOMETRICPROJECTION_H
@@ -43,6 +43,7 @@ public:
     OpReduceNoise(Process *parent);
     OpReduceNoise *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 private:
     OperatorParameterSlider *m_order;
 };
@@ -130,7 +130,7 @@ public:
                 photo.setTag(TAG_NAME, tr("LRGB Composition"));
                 Ordinary::Pixels iPhoto_cache(photo.image());
                 Magick::PixelPacket *pxl = iPhoto_cache.get(0, 0, w, h);
-                dfl_block int line = 0;
+                emitProgress(i, photo_count, 0, h);
                 bool hdrLuminance = pLuminance.getScale() == Photo::HDR;
                 bool hdrRed = pRed.getScale() == Photo::HDR;
                 bool hdrGreen = pGreen.getScale() == Photo::HDR;
@@ -177,10 +177,7 @@ public:
                             pxl[y*w+x].blue=clamp<quantum_t>(DF_ROUND(blue));
                         }
                     }
-                    dfl_critical_section(
-                    {
-                        emitProgress(i, photo_count,line++, h);
-                    });
+                    advanceProgress();
                 });
                 iPhoto_cache.sync();
                 if (m_outputHDR)
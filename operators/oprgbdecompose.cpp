@@ -71,7 +71,7 @@ public:
                 std::shared_ptr<Ordinary::Pixels> iLuminance_cache(new Ordinary::Pixels(iLuminance));
                 int w = srcImage.columns();
                 int h = srcImage.rows();
-                dfl_block int line = 0;
+                emitProgress(p, c, 0, h);
                 dfl_parallel_for(y, 0, h, 4, (srcImage, iRed, iGreen, iBlue, iLuminance),{
                     const Magick::PixelPacket *src = src_cache->getConst(0, y, w, 1);
                     Magick::PixelPacket *pxl_Red = iRed_cache->get(0, y, w, 1);
@@ -95,9 +95,7 @@ public:
                     iGreen_cache->sync();
                     iBlue_cache->sync();
                     iLuminance_cache->sync();
-                    dfl_critical_section({
-                        emitProgress(p, c, line++, h);
-                    });
+                    advanceProgress();
                 });
                 outputPush(0, pLuminance);
                 outputPush(1, pRed);
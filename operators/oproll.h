@@ -43,6 +43,7 @@ public:
     OpRoll(Process *parent);
     OpRoll *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 private:
     OperatorParameterSlider *m_columns;
     OperatorParameterSlider *m_rows;
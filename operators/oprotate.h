@@ -45,6 +45,7 @@ public:
 
     OpRotate *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
     qreal angle() const;
 
 private slots:
@@ -125,6 +125,12 @@ OperatorWorker *OpSave::newWorker()
     return new WorkerSave(m_directory->currentValue(), m_fileTypeValue, m_backupValue, m_thread, this);
 }
 
+bool OpSave::isCacheable() const
+{
+    // saving is the whole point, it must run every time
+    return false;
+}
+
 void OpSave::selectType(int v)
 {
     if ( m_fileTypeValue != v ) {
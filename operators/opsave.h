@@ -49,6 +49,7 @@ public:
     OpSave(Process *parent);
     OpSave *newInstance();
     OperatorWorker *newWorker();
+    bool isCacheable() const;
 private slots:
     void selectType(int v);
     void selectBackup(int v);
@@ -49,6 +49,7 @@ public:
 
     OpSelectiveLabFilter *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 
     Algorithm *getAlgorithm() const;
     void releaseAlgorithm(Algorithm *algo) const;
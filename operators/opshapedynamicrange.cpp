@@ -94,6 +94,21 @@ OperatorWorker *OpShapeDynamicRange::newWorker()
   return new WorkerShapeDR(m_shape, m_dynamicRange->value(), m_exposure->value(), m_labDomain, m_thread, this);
 }
 
+Algorithm *OpShapeDynamicRange::getAlgorithm() const
+{
+    return new ShapeDynamicRange(m_shape, m_dynamicRange->value(), m_exposure->value(), m_labDomain);
+}
+
+void OpShapeDynamicRange::releaseAlgorithm(Algorithm *algo) const
+{
+    delete algo;
+}
+
+bool OpShapeDynamicRange::isStreamable() const
+{
+    return true;
+}
+
 void OpShapeDynamicRange::selectShape(int shape)
 {
     if ( m_shape != shape ) {
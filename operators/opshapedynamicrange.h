@@ -44,6 +44,10 @@ public:
     OpShapeDynamicRange(Process *parent);
     OpShapeDynamicRange *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
+    Algorithm *getAlgorithm() const;
+    void releaseAlgorithm(Algorithm *algo) const;
+    bool isStreamable() const;
 private slots:
     void selectShape(int);
     void selectLab(int v);
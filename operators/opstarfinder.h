@@ -43,6 +43,7 @@ public:
     OpStarFinder(Process *parent);
     OpStarFinder *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 
     bool isBeta() const { return true; }
 
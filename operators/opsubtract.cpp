@@ -60,25 +60,23 @@ public:
             dflError("size mismatch");
             return;
         }
-        Magick::Image &srcImage(minuend);
-        ResetImage(minuend);
+        minuend.modifyImage();
         ResetImage(underflow);
-        std::shared_ptr<Ordinary::Pixels> src_cache(new Ordinary::Pixels(srcImage));
         std::shared_ptr<Ordinary::Pixels> minuend_cache(new Ordinary::Pixels(minuend));
         std::shared_ptr<Ordinary::Pixels> subtrahend_cache(new Ordinary::Pixels(subtrahend));
         std::shared_ptr<Ordinary::Pixels> addend_cache(0);
         if (addend)
             addend_cache.reset(new Ordinary::Pixels(*addend));
         std::shared_ptr<Ordinary::Pixels> underflow_cache(new Ordinary::Pixels(underflow));
-        dfl_parallel_for(y, 0, h, 4, (srcImage, minuend, subtrahend, addend?*addend:Magick::Image()), {
-            const Magick::PixelPacket *src = src_cache->getConst(0, y, w, 1);
+        dfl_parallel_for(y, 0, h, 4, (minuend, subtrahend, addend?*addend:Magick::Image()), {
             Magick::PixelPacket *minuend_pixels = minuend_cache->get(0, y, w, 1);
+            const Magick::PixelPacket *src = minuend_pixels;
             Magick::PixelPacket *underflow_pixels = underflow_cache->get(0, y, w,1);
             const Magick::PixelPacket *subtrahend_pixels = subtrahend_cache->getConst(0, (1 == s_h ? 0 : y), s_w, 1);
             const Magick::PixelPacket *addend_pixels = NULL;
             if ( addend_cache )
                 addend_pixels = addend_cache->getConst(0, (1 == s_h ? 0 : y), s_w, 1);
-            if ( m_error || !src || !minuend_pixels || !underflow_pixels || !subtrahend_pixels || (addend_cache && !addend_pixels) ) {
+            if ( m_error || !minuend_pixels || !underflow_pixels || !subtrahend_pixels || (addend_cache && !addend_pixels) ) {
                 if ( !m_error )
                     dflError(DF_NULL_PIXELS);
                 continue;
@@ -142,7 +140,7 @@ public:
 
                 outputPush(0, minuend);
                 outputPush(1, underflow);
-                emit progress(n, n_photos);
+                setProgress(n, n_photos);
             }
             ++n_sub;
         }
@@ -44,6 +44,7 @@ public:
     OperatorWorker *newWorker();
 
     bool isDeprecated() const;
+    bool isShardable() const { return true; }
 signals:
 
 public slots:
@@ -36,7 +36,6 @@
 #include "operatorparameterslider.h"
 #include "operatorparameterdropdown.h"
 #include "channelmixer.h"
-#include "invert.h"
 #include "cielab.h"
 #include <Magick++.h>
 
@@ -50,11 +49,9 @@ public:
                     bool mask,
                     QThread *thread, Operator *op) :
         OperatorWorker(thread, op),
-        m_threshold(high, low),
+        m_threshold(high, low, invert),
         m_channelMixer(LUMINANCE_RED, LUMINANCE_GREEN, LUMINANCE_BLUE),
         m_component(component),
-        m_invert(),
-        m_invertValue(invert),
         m_mask(mask)
     {
     }
@@ -63,9 +60,6 @@ public:
         if (m_component == OpThreshold::ComponentLuminosity)
             m_channelMixer.applyOn(newPhoto);
         m_threshold.applyOn(newPhoto);
-        if (m_invertValue) {
-            m_invert.applyOn(newPhoto);
-        }
         if (!m_mask) {
             Photo srcPhoto(photo);
             Photo dstPhoto(photo);
@@ -98,8 +92,6 @@ private:
     Threshold m_threshold;
     ChannelMixer m_channelMixer;
     OpThreshold::Component m_component;
-    Invert m_invert;
-    bool m_invertValue;
     bool m_mask;
 };
 
@@ -148,6 +140,22 @@ OperatorWorker *OpThreshold::newWorker()
                                m_thread, this);
 }
 
+Algorithm *OpThreshold::getAlgorithm() const
+{
+    return new Threshold(m_high->value(), m_low->value(), m_invertValue);
+}
+
+void OpThreshold::releaseAlgorithm(Algorithm *algo) const
+{
+    delete algo;
+}
+
+bool OpThreshold::isStreamable() const
+{
+    /* the luminosity and the masking are not point-wise tables */
+    return m_componentValue == ComponentRGB && m_maskValue;
+}
+
 void OpThreshold::selectComponent(int v)
 {
     if ( m_componentValue != Component(v) ) {
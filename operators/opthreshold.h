@@ -49,6 +49,10 @@ public:
     OpThreshold(Process *parent);
     OpThreshold *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
+    Algorithm *getAlgorithm() const;
+    void releaseAlgorithm(Algorithm *algo) const;
+    bool isStreamable() const;
 
 public slots:
     void selectComponent(int v);
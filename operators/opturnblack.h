@@ -41,6 +41,7 @@ public:
     OpTurnBlack(Process *parent);
     OpTurnBlack *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 };
 
 #endif // OPTURNBLACK_H
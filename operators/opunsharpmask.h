@@ -43,6 +43,7 @@ public:
     OpUnsharpMask(Process *parent);
     OpUnsharpMask *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 private:
     OperatorParameterSlider *m_radius;
     OperatorParameterSlider *m_sigma;
@@ -85,6 +85,21 @@ OperatorWorker *OpWhiteBalance::newWorker()
     return new WorkerWhiteBalance(m_temperature->value(), m_tint->value(), m_safe, m_thread, this);
 }
 
+Algorithm *OpWhiteBalance::getAlgorithm() const
+{
+    return new WhiteBalance(m_temperature->value(), m_tint->value(), m_safe);
+}
+
+void OpWhiteBalance::releaseAlgorithm(Algorithm *algo) const
+{
+    delete algo;
+}
+
+bool OpWhiteBalance::isStreamable() const
+{
+    return true;
+}
+
 
 void OpWhiteBalance::setSafe(int v)
 {
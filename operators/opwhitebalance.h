@@ -45,6 +45,10 @@ public:
 
     OpWhiteBalance *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
+    Algorithm *getAlgorithm() const;
+    void releaseAlgorithm(Algorithm *algo) const;
+    bool isStreamable() const;
 
 public slots:
     void setSafe(int v);
@@ -44,6 +44,7 @@ public:
     OpWindowFunction(Process *parent);
     OpWindowFunction *newInstance();
     OperatorWorker *newWorker();
+    bool isPipelinable() const { return true; }
 
 private slots:
     void selectWindow(int v);
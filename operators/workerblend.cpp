@@ -276,7 +276,7 @@ void WorkerBlend::play()
                 c_w = imageC->columns();
                 c_h = imageC->rows();
             }
-            dfl_block int line = 0;
+            emitProgress(n, a_count, 0, h);
             bool aHDR = photoA.getScale() == Photo::HDR;
             bool bHDR = photoB && photoB->getScale() == Photo::HDR;
             bool cHDR = photoC && photoC->getScale() == Photo::HDR ;
@@ -333,12 +333,7 @@ void WorkerBlend::play()
                 imageA_cache->sync();
                 underflow_cache->sync();
                 overflow_cache->sync();
-                dfl_critical_section(
-                {
-                    if ( line % 100 == 0)
-                        emitProgress(n, a_count, line, h);
-                    ++line;
-                });
+                advanceProgress();
             });
 
             if ( b_h == 1 && b_w == 1 &&
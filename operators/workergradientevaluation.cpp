@@ -107,7 +107,7 @@ Photo WorkerGradientEvaluation::process(const Photo &srcPhoto, int p, int c)
     Ordinary::Pixels out_cache(out);
     Magick::PixelPacket *pxl = out_cache.get(0, 0, w, h);
 
-    dfl_block int line=0;
+    emitProgress(p, c, 0, h);
     qreal altitude = m_altitude*m_altitude;
     dfl_parallel_for(y, 0, h, 4, (), {
         for ( int x = 0 ; x < w ; ++x ) {
@@ -141,10 +141,7 @@ Photo WorkerGradientEvaluation::process(const Photo &srcPhoto, int p, int c)
             }
 
         }
-        dfl_critical_section(
-        {
-            emitProgress(p, c, line++, h);
-        });
+        advanceProgress();
     });
     out_cache.sync();
 
@@ -36,8 +36,10 @@
 #include "hdr.h"
 #include "transformview.h"
 #include "cielab.h"
+#include "integrationstack.h"
 #include <Magick++.h>
 #include <cmath>
+#include <vector>
 
 #include <QVector>
 #include <QPointF>
@@ -45,6 +47,232 @@
 
 using Magick::Quantum;
 
+/* bytes of pixel stacks a thread works on at once, to stay in its cache */
+#define DF_STACK_BUDGET (1<<20)
+#define DF_STACK_MIN_PIXELS 64
+/* side of the output tiles drizzled by a thread */
+#define DF_DRIZZLE_TILE 128
+
+/**
+ * @brief The FrameExposure class converts the pixels of a frame to the
+ * linear scale of the integration and drops those outside of the range
+ * its HDR exposure compensation applies to
+ */
+class FrameExposure {
+public:
+    FrameExposure() :
+        m_hdr(false),
+        m_altered(false),
+        m_automatic(false),
+        m_comp(1),
+        m_high(QuantumRange),
+        m_low(0)
+    {}
+    explicit FrameExposure(const Photo& photo) :
+        m_hdr(photo.getScale() == Photo::HDR),
+        m_altered(false),
+        m_automatic(false),
+        m_comp(1),
+        m_high(QuantumRange),
+        m_low(0)
+    {
+        QString hdrCompStr = photo.getTag(TAG_HDR_COMP);
+        QString hdrHighStr = photo.getTag(TAG_HDR_HIGH);
+        QString hdrLowStr = photo.getTag(TAG_HDR_LOW);
+        QString hdrAutomaticStr = photo.getTag(TAG_HDR_AUTO);
+        if ( !hdrCompStr.isEmpty() &&
+             !hdrHighStr.isEmpty() &&
+             !hdrLowStr.isEmpty() &&
+             !hdrAutomaticStr.isEmpty()) {
+            m_altered = true;
+            m_comp = hdrCompStr.toDouble();
+            m_high = hdrHighStr.toDouble() * QuantumRange;
+            m_low = hdrLowStr.toDouble() * QuantumRange;
+            m_automatic = !!hdrAutomaticStr.toInt();
+        }
+    }
+
+    /**
+     * @brief load
+     * @return false if the pixel is out of the compensated range
+     */
+    bool load(const Magick::PixelPacket& pixel, double rgb[3]) const {
+        if ( m_hdr ) {
+            rgb[0] = fromHDR(pixel.red);
+            rgb[1] = fromHDR(pixel.green);
+            rgb[2] = fromHDR(pixel.blue);
+        }
+        else {
+            rgb[0] = pixel.red;
+            rgb[1] = pixel.green;
+            rgb[2] = pixel.blue;
+        }
+        if ( m_altered ) {
+            qreal lum = LUMINANCE(rgb[0], rgb[1], rgb[2]);
+            if ( !m_automatic && (lum < m_low || lum > m_high) )
+                return false;
+            rgb[0] /= m_comp;
+            rgb[1] /= m_comp;
+            rgb[2] /= m_comp;
+        }
+        return true;
+    }
+
+private:
+    bool m_hdr;
+    bool m_altered;
+    bool m_automatic;
+    qreal m_comp;
+    qreal m_high;
+    qreal m_low;
+};
+
+/* the mean and the deviation are computed together, with Welford's
+ * running updates, so that the frames are read twice at most */
+enum Phase {
+    PhaseMinMax = 0,
+    PhaseStatistics,
+    PhaseIntegration,
+    LastPhase
+};
+
+typedef WorkerIntegration::integration_plane_t integration_plane_t;
+
+/**
+ * @brief The IntegrationRow struct is what a row kernel works on: a row of
+ * a frame, loaded, and the same row of each plane. Undefined sub-pixels,
+ * out of the frame or of its exposure range, are left out
+ */
+struct IntegrationRow {
+    int w;
+    const double *rgb;
+    const int *defined;
+    const Magick::PixelPacket *pixels;
+    Magick::PixelPacket *rej;
+    integration_plane_t *integration;
+    int *count;
+    integration_plane_t *min;
+    integration_plane_t *max;
+    integration_plane_t *average;
+    integration_plane_t *stdDev;
+    qreal upper;
+    qreal lower;
+    long total;
+    long rejected;
+};
+
+typedef void (*IntegrationRowKernel)(IntegrationRow& row);
+
+static integration_plane_t *planeRow(integration_plane_t *plane, int y, int w)
+{
+    return plane ? plane + size_t(y)*w*3 : NULL;
+}
+
+static void minMaxRow(IntegrationRow& row)
+{
+    for (int i = 0, s = row.w*3 ; i < s ; ++i) {
+        double v = row.rgb[i];
+        bool d = row.defined[i];
+        row.min[i] = d ? qMin(row.min[i], v) : row.min[i];
+        row.max[i] = d ? qMax(row.max[i], v) : row.max[i];
+    }
+}
+
+/* m_stdDevPlane holds the sum of the squared deviations until the end
+ * of the phase */
+static void statisticsRow(IntegrationRow& row)
+{
+    for (int i = 0, s = row.w*3 ; i < s ; ++i) {
+        if ( !row.defined[i] )
+            continue;
+        double v = row.rgb[i];
+        int n = ++row.count[i];
+        double delta = v - row.average[i];
+        row.average[i] += delta / n;
+        if (row.stdDev)
+            row.stdDev[i] += delta * (v - row.average[i]);
+    }
+}
+
+template<int R>
+static inline bool keep(const IntegrationRow&, int, double)
+{
+    return true;
+}
+
+template<>
+inline bool keep<OpIntegration::MinMax>(const IntegrationRow& row, int i, double v)
+{
+    return v > row.min[i] && v < row.max[i];
+}
+
+template<>
+inline bool keep<OpIntegration::AverageDeviation>(const IntegrationRow& row, int i, double v)
+{
+    return v >= row.average[i]/row.lower && v <= row.average[i]*row.upper;
+}
+
+template<>
+inline bool keep<OpIntegration::SigmaClipping>(const IntegrationRow& row, int i, double v)
+{
+    return v >= row.average[i]-row.stdDev[i]*row.lower &&
+            v <= row.average[i]+row.stdDev[i]*row.upper;
+}
+
+/**
+ * the rejection is a template parameter, the inner loop has no branch left
+ * but the ones of the test itself
+ */
+template<int R>
+static void integrateRow(IntegrationRow& row)
+{
+    long total = 0;
+    long kept = 0;
+    for (int i = 0, s = row.w*3 ; i < s ; ++i) {
+        double v = row.rgb[i];
+        int k = row.defined[i] & int(keep<R>(row, i, v));
+        row.integration[i] += k ? v : 0;
+        row.count[i] += k;
+        total += row.defined[i];
+        kept += k;
+    }
+    row.total += total;
+    row.rejected += total - kept;
+    if ( !row.rej )
+        return;
+    for (int x = 0 ; x < row.w ; ++x) {
+        if ( !row.defined[x*3] )
+            continue;
+        const Magick::PixelPacket& pixel = row.pixels[x];
+        Magick::PixelPacket& rej = row.rej[x];
+        rej.red = keep<R>(row, x*3+0, row.rgb[x*3+0]) ? 0 : pixel.red;
+        rej.green = keep<R>(row, x*3+1, row.rgb[x*3+1]) ? 0 : pixel.green;
+        rej.blue = keep<R>(row, x*3+2, row.rgb[x*3+2]) ? 0 : pixel.blue;
+    }
+}
+
+static IntegrationRowKernel rowKernel(int phase, OpIntegration::RejectionType type)
+{
+    switch (phase) {
+    case PhaseMinMax:
+        return minMaxRow;
+    case PhaseStatistics:
+        return statisticsRow;
+    default:
+        break;
+    }
+    switch (type) {
+    case OpIntegration::MinMax:
+        return integrateRow<OpIntegration::MinMax>;
+    case OpIntegration::AverageDeviation:
+        return integrateRow<OpIntegration::AverageDeviation>;
+    case OpIntegration::SigmaClipping:
+        return integrateRow<OpIntegration::SigmaClipping>;
+    default:
+        return integrateRow<OpIntegration::NoRejection>;
+    }
+}
+
 WorkerIntegration::WorkerIntegration(OpIntegration::RejectionType rejectionType,
                                      qreal upper,
                                      qreal lower,
@@ -52,6 +280,9 @@ WorkerIntegration::WorkerIntegration(OpIntegration::RejectionType rejectionType,
                                      qreal customNormalizationValue,
                                      bool outputHDR,
                                      qreal scale,
+                                     TransformView::Interpolation interpolation,
+                                     bool drizzle,
+                                     qreal pixfrac,
                                      QThread *thread,
                                      OpIntegration *op) :
     OperatorWorker(thread, op),
@@ -71,7 +302,10 @@ WorkerIntegration::WorkerIntegration(OpIntegration::RejectionType rejectionType,
     m_h(0),
     m_offX(0),
     m_offY(0),
-    m_scale(scale)
+    m_scale(scale),
+    m_interpolation(interpolation),
+    m_drizzle(drizzle),
+    m_pixfrac(pixfrac)
 {
     dflWarning(tr("H: %0, L: %1").arg(m_upper).arg(m_lower));
 }
@@ -142,20 +376,10 @@ bool WorkerIntegration::play_onInput(int idx)
         emitSuccess();
         return false;
     }
-    enum Phase {
-        PhaseMinMax = 0,
-        PhaseMean,
-        PhaseStdDev,
-        PhaseIntegration,
-        LastPhase
-    };
     bool skip[LastPhase] = {};
     int nPhases = LastPhase;
     switch (m_rejectionType) {
     case OpIntegration::AverageDeviation:
-        skip[PhaseStdDev] = true;
-        --nPhases;
-        // Falls through
     case OpIntegration::SigmaClipping:
         skip[PhaseMinMax] = true;
         --nPhases;
@@ -168,15 +392,45 @@ bool WorkerIntegration::play_onInput(int idx)
         --nPhases;
         // Falls through
     case OpIntegration::MinMax:
-        skip[PhaseMean] = true;
-        --nPhases;
-        skip[PhaseStdDev] = true;
+        skip[PhaseStatistics] = true;
         --nPhases;
         break;
+    case OpIntegration::Median:
+    case OpIntegration::WinsorizedSigmaClipping:
+    case OpIntegration::LinearFitClipping:
+        /* integrated tile by tile by integrateStacks() */
+        for (int phase = 0 ; phase < LastPhase ; ++phase)
+            skip[phase] = true;
+        nPhases = 0;
+        break;
+    }
+    if ( m_drizzle ) {
+        if ( m_rejectionType != OpIntegration::NoRejection )
+            dflWarning(tr("Drizzle integration ignores the rejection"));
+        for (int phase = 0 ; phase < LastPhase ; ++phase)
+            skip[phase] = true;
+        nPhases = 0;
     }
     int phaseN=0;
     dfl_block long totalPixels=0;
     dfl_block long rejected=0;
+    if ( m_drizzle || IntegrationStack::isStacked(m_rejectionType) ) {
+        try {
+            createPlanes(refPhoto->image());
+            bool done = m_drizzle
+                    ? drizzle(reference, totalPixels)
+                    : integrateStacks(reference, totalPixels, rejected);
+            if ( !done ) {
+                emitFailure();
+                return false;
+            }
+        }
+        catch (std::exception &e) {
+            dflError("%s", e.what());
+            emitFailure();
+            return false;
+        }
+    }
     for (int phase = PhaseMinMax ; phase < LastPhase ; ++phase) {
         photoN = 0;
         if (skip[phase])
@@ -195,28 +449,9 @@ bool WorkerIntegration::play_onInput(int idx)
                 if ( ! m_integrationPlane ) {
                     createPlanes(refPhoto->image());
                 }
-                dfl_block int line = 0;
-
-                bool hdr = photo.getScale() == Photo::HDR;
-                bool hdrExposureAltered = false;
-                bool hdrAutomatic = false;
-                QString hdrCompStr = photo.getTag(TAG_HDR_COMP);
-                QString hdrHighStr = photo.getTag(TAG_HDR_HIGH);
-                QString hdrLowStr = photo.getTag(TAG_HDR_LOW);
-                QString hdrAutomaticStr = photo.getTag(TAG_HDR_AUTO);
-                qreal hdrComp = 1,
-                        hdrHigh = QuantumRange,
-                        hdrLow = 0;
-                if ( !hdrCompStr.isEmpty() &&
-                     !hdrHighStr.isEmpty() &&
-                     !hdrLowStr.isEmpty() &&
-                     !hdrAutomaticStr.isEmpty()) {
-                    hdrExposureAltered = true;
-                    hdrComp = hdrCompStr.toDouble();
-                    hdrHigh = hdrHighStr.toDouble() * QuantumRange;
-                    hdrLow = hdrLowStr.toDouble() * QuantumRange;
-                    hdrAutomatic = !!hdrAutomaticStr.toInt();
-                }
+                emitProgress(phaseN*photoCount+photoN, photoCount*nPhases, 0, m_h);
+
+                FrameExposure exposure(photo);
                 std::shared_ptr<TransformView> view(new TransformView(photo, m_scale, reference));
                 if (view->inError()) {
                     dflError(tr("view in error"));
@@ -226,6 +461,7 @@ bool WorkerIntegration::play_onInput(int idx)
                     dflError(tr("unable to load pixels"));
                     continue;
                 }
+                view->setInterpolation(m_interpolation);
 #ifdef TRANSFORM_POINTS
                 {
                     qreal x, y;
@@ -256,123 +492,41 @@ bool WorkerIntegration::play_onInput(int idx)
                     rejPixels = rejCache->get(0, 0, m_w, m_h);
                 }
 #define SUBPXL(plane, x,y,c) plane[(y)*m_w*3+(x)*3+(c)]
+                IntegrationRowKernel kernel = rowKernel(phase, m_rejectionType);
                 dfl_parallel_for(y, 0, m_h, 4, (), {
+                    std::vector<double> rgb(m_w*3, 0.);
+                    std::vector<int> defined(m_w*3, 0);
+                    QVector<Magick::PixelPacket> pixels(m_w);
+                    QVector<bool> inside(m_w);
+                    view->getRow(y, 0, m_w, pixels.data(), inside.data());
                     for ( int x = 0 ; x < m_w ; ++x ) {
-                        bool defined;
-                        Magick::PixelPacket pixel = view->getPixel(x,y,&defined);
-                        if (!defined)
+                        if ( !inside[x] || !exposure.load(pixels[x], &rgb[x*3]) )
                             continue;
-                        integration_plane_t red, green, blue;
-                        if ( hdr ) {
-                            red = fromHDR(pixel.red);
-                            green = fromHDR(pixel.green);
-                            blue = fromHDR(pixel.blue);
-                        }
-                        else {
-                            red = pixel.red;
-                            green = pixel.green;
-                            blue = pixel.blue;
-                        }
-                        if ( hdrExposureAltered ) {
-                            qreal lum = LUMINANCE(red, green, blue);
-                            if ( hdrAutomatic || (lum >= hdrLow && lum <= hdrHigh) ) {
-                                red/=hdrComp;
-                                green/=hdrComp;
-                                blue/=hdrComp;
-                            }
-                            else {
-                                 continue;
-                            }
-                         }
-                         switch (phase) {
-                             case PhaseIntegration: {
-                                 double rgb[3] = { red, green, blue };
-                                 for (int i = 0 ; i < 3 ; ++i) {
-                                     bool reject = true;
-                                     switch(m_rejectionType) {
-                                         default:
-                                         case OpIntegration::NoRejection:
-                                         reject  = false;
-                                         break;
-                                         case OpIntegration::MinMax:
-                                         if ( rgb[i] > SUBPXL(m_minPlane,x,y,i) &&
-                                              rgb[i] < SUBPXL(m_maxPlane,x,y,i) )
-                                             reject = false;
-                                         break;
-                                         case OpIntegration::AverageDeviation:
-                                         if ( rgb[i] >= SUBPXL(m_averagePlane,x,y,i)/m_lower &&
-                                              rgb[i] <= SUBPXL(m_averagePlane,x,y,i)*m_upper)
-                                             reject = false;
-                                         break;
-                                         case OpIntegration::SigmaClipping:
-                                         if ( rgb[i] >= SUBPXL(m_averagePlane,x,y,i)-SUBPXL(m_stdDevPlane,x,y,i)*m_lower &&
-                                              rgb[i] <= SUBPXL(m_averagePlane,x,y,i)+SUBPXL(m_stdDevPlane,x,y,i)*m_upper)
-                                             reject = false;
-                                         break;
-                                     }
-                                     atomic_incr(&totalPixels);
-                                     if (!reject) {
-                                         SUBPXL(m_integrationPlane,x,y,i) += rgb[i];
-                                         ++SUBPXL(m_countPlane,x,y,i);
-                                         if (rejPixels) {
-                                             switch(i) {
-                                                 case 0:
-                                                 rejPixels[y*m_w+x].red = 0; break;
-                                                 case 1:
-                                                 rejPixels[y*m_w+x].green = 0; break;
-                                                 case 2:
-                                                 rejPixels[y*m_w+x].blue = 0; break;
-                                             }
-                                         }
-                                     }
-                                     else {
-                                        atomic_incr(&rejected);
-                                        if (rejPixels) {
-                                            switch(i) {
-                                                case 0:
-                                                rejPixels[y*m_w+x].red = pixel.red; break;
-                                                case 1:
-                                                rejPixels[y*m_w+x].green = pixel.green; break;
-                                                case 2:
-                                                rejPixels[y*m_w+x].blue = pixel.blue; break;
-                                            }
-                                        }
-                                     }
-                                 }
-                                 break;
-                             }
-                             case PhaseMinMax:
-                             SUBPXL(m_minPlane,x,y,0) = qMin(SUBPXL(m_minPlane,x,y,0), red);
-                             SUBPXL(m_minPlane,x,y,1) = qMin(SUBPXL(m_minPlane,x,y,1), green);
-                             SUBPXL(m_minPlane,x,y,2) = qMin(SUBPXL(m_minPlane,x,y,2), blue);
-                             SUBPXL(m_maxPlane,x,y,0) = qMax(SUBPXL(m_maxPlane,x,y,0), red);
-                             SUBPXL(m_maxPlane,x,y,1) = qMax(SUBPXL(m_maxPlane,x,y,1), green);
-                             SUBPXL(m_maxPlane,x,y,2) = qMax(SUBPXL(m_maxPlane,x,y,2), blue);
-                             break;
-                             case PhaseMean:
-                             SUBPXL(m_averagePlane,x,y,0) += red;
-                             SUBPXL(m_averagePlane,x,y,1) += green;
-                             SUBPXL(m_averagePlane,x,y,2) += blue;
-                             ++SUBPXL(m_countPlane,x,y,0);
-                             ++SUBPXL(m_countPlane,x,y,1);
-                             ++SUBPXL(m_countPlane,x,y,2);
-                             break;
-                             case PhaseStdDev:
-                             SUBPXL(m_stdDevPlane,x,y,0) += pow(red-SUBPXL(m_averagePlane,x,y,0), 2);
-                             SUBPXL(m_stdDevPlane,x,y,1) += pow(green-SUBPXL(m_averagePlane,x,y,1), 2);
-                             SUBPXL(m_stdDevPlane,x,y,2) += pow(blue-SUBPXL(m_averagePlane,x,y,2), 2);
-                             ++SUBPXL(m_countPlane,x,y,0);
-                             ++SUBPXL(m_countPlane,x,y,1);
-                             ++SUBPXL(m_countPlane,x,y,2);
-                             break;
-                         }
-                     }
-                    dfl_critical_section(
-                    {
-                        ++line;
-                        if ( 0 == line % 100 )
-                            emitProgress(phaseN*photoCount+photoN, photoCount*nPhases, line, m_h);
-                    });
+                        defined[x*3+0] = defined[x*3+1] = defined[x*3+2] = 1;
+                    }
+                    IntegrationRow row;
+                    row.w = m_w;
+                    row.rgb = rgb.data();
+                    row.defined = defined.data();
+                    row.pixels = pixels.data();
+                    row.rej = rejPixels ? rejPixels + y*m_w : NULL;
+                    row.integration = planeRow(m_integrationPlane, y, m_w);
+                    row.count = m_countPlane + size_t(y)*m_w*3;
+                    row.min = planeRow(m_minPlane, y, m_w);
+                    row.max = planeRow(m_maxPlane, y, m_w);
+                    row.average = planeRow(m_averagePlane, y, m_w);
+                    row.stdDev = planeRow(m_stdDevPlane, y, m_w);
+                    row.upper = m_upper;
+                    row.lower = m_lower;
+                    row.total = 0;
+                    row.rejected = 0;
+                    kernel(row);
+                    /* one atomic add per row rather than two per sub-pixel */
+                    if (row.total)
+                        atomic_add(&totalPixels, row.total);
+                    if (row.rejected)
+                        atomic_add(&rejected, row.rejected);
+                    advanceProgress();
                 });
                 if (rejPhoto) {
                     rejCache->sync();
@@ -388,21 +542,10 @@ bool WorkerIntegration::play_onInput(int idx)
                 return false;
             }
         }
-        if (phase == PhaseMean) {
-            for(int i=0, s=m_w*m_h*3 ; i < s ; ++i) {
-                if (m_countPlane[i])
-                    m_averagePlane[i] /= m_countPlane[i];
-                else
-                    m_averagePlane[i] = 0;
-                m_countPlane[i] = 0;
-            }
-        }
-        else if (phase == PhaseStdDev) {
+        if (phase == PhaseStatistics) {
             for(int i=0, s=m_w*m_h*3 ; i < s ; ++i) {
-                if (m_countPlane[i])
+                if (m_stdDevPlane && m_countPlane[i])
                     m_stdDevPlane[i] = sqrt(m_stdDevPlane[i]/m_countPlane[i]);
-                else
-                    m_stdDevPlane[i] = 0;
                 m_countPlane[i] = 0;
             }
         }
@@ -465,13 +608,281 @@ bool WorkerIntegration::play_onInput(int idx)
     return true;
 }
 
+/**
+ * @brief WorkerIntegration::integrateStacks integrates tile by tile for the
+ * rejections that need every value of a sub-pixel: each tile is gathered
+ * from all the frames into contiguous stacks, small enough to stay in cache,
+ * then each stack is combined as a whole. The tiles are spread on the threads
+ */
+bool WorkerIntegration::integrateStacks(const QVector<QPointF> &reference,
+                                        long &totalPixels, long &rejected)
+{
+    QVector<std::shared_ptr<TransformView> > views;
+    QVector<FrameExposure> exposures;
+    QVector<Photo> rejPhotos;
+    QVector<std::shared_ptr<Ordinary::Pixels> > rejCaches;
+    QVector<Magick::PixelPacket*> rejPixels;
+    bool rejectionMaps = m_rejectionType != OpIntegration::Median && outputEnabled(1);
+    foreach(Photo photo, m_inputs[0]) {
+        if ( photo.getScale() == Photo::NonLinear ) {
+            dflWarning(tr("%0 is non-linear").arg(photo.getIdentity()));
+        }
+        std::shared_ptr<TransformView> view(new TransformView(photo, m_scale, reference));
+        if (view->inError()) {
+            dflError(tr("view in error"));
+            continue;
+        }
+        if (!view->loadPixels()) {
+            dflError(tr("unable to load pixels"));
+            continue;
+        }
+        view->setInterpolation(m_interpolation);
+        views.push_back(view);
+        exposures.push_back(FrameExposure(photo));
+        if (rejectionMaps) {
+            Photo rejPhoto(photo);
+            rejPhoto.createImage(m_w, m_h);
+            std::shared_ptr<Ordinary::Pixels> cache(new Ordinary::Pixels(rejPhoto.image()));
+            rejPixels.push_back(cache->get(0, 0, m_w, m_h));
+            rejCaches.push_back(cache);
+            rejPhotos.push_back(rejPhoto);
+        }
+    }
+    int frames = views.count();
+    if ( 0 == frames )
+        return true;
+
+    /* a tile pixel holds the values of its 3 channels and their frames,
+     * and the source pixels when they go to the rejection maps */
+    qint64 pixelBytes = qint64(frames) * (3 * sizeof(float) + sizeof(int) +
+                                          (rejectionMaps ? sizeof(Magick::PixelPacket) : 0));
+    int tilePixels = qMax<qint64>(DF_STACK_MIN_PIXELS, DF_STACK_BUDGET / pixelBytes);
+    int tileW = qMin(m_w, tilePixels);
+    int tileH = qBound(1, tilePixels / tileW, m_h);
+    int tilesX = (m_w + tileW - 1) / tileW;
+    int tiles = tilesX * ((m_h + tileH - 1) / tileH);
+    dflDebug(tr("Stacks of %0 frames, %1 tiles of %2x%3").arg(frames).arg(tiles).arg(tileW).arg(tileH));
+    setProgress(0, tiles);
+
+    dfl_block long total = 0;
+    dfl_block long rejectedCount = 0;
+    dfl_parallel_for(t, 0, tiles, 1, (), {
+        if ( aborted() )
+            continue;
+        int x0 = (t % tilesX) * tileW;
+        int y0 = (t / tilesX) * tileH;
+        int w = qMin(tileW, m_w - x0);
+        int h = qMin(tileH, m_h - y0);
+        /* the stack of the channel c of the tile pixel p starts at
+         * (p*3+c)*frames, the frames it comes from at p*frames */
+        std::vector<float> values(size_t(w) * h * 3 * frames);
+        std::vector<int> sources(size_t(w) * h * frames);
+        std::vector<Magick::PixelPacket> sourcePixels(rejectionMaps ? size_t(w) * h * frames : 0);
+        std::vector<int> counts(size_t(w) * h, 0);
+        std::vector<float> scratch(frames);
+        QVector<Magick::PixelPacket> pixels(w);
+        QVector<bool> defined(w);
+        for (int f = 0 ; f < frames ; ++f ) {
+            for (int y = 0 ; y < h ; ++y ) {
+                views[f]->getRow(y0 + y, x0, w, pixels.data(), defined.data());
+                for (int x = 0 ; x < w ; ++x ) {
+                    double rgb[3];
+                    if ( !defined[x] || !exposures[f].load(pixels[x], rgb) )
+                        continue;
+                    int p = y * w + x;
+                    int k = counts[p]++;
+                    sources[size_t(p) * frames + k] = f;
+                    if ( rejectionMaps )
+                        sourcePixels[size_t(p) * frames + k] = pixels[x];
+                    for (int c = 0 ; c < 3 ; ++c )
+                        values[(size_t(p) * 3 + c) * frames + k] = rgb[c];
+                }
+            }
+        }
+        long tileTotal = 0;
+        long tileRejected = 0;
+        for (int p = 0, s = w * h ; p < s ; ++p ) {
+            int x = x0 + p % w;
+            int y = y0 + p / w;
+            int k = counts[p];
+            for (int c = 0 ; c < 3 ; ++c ) {
+                const float *stack = &values[(size_t(p) * 3 + c) * frames];
+                float low, high;
+                SUBPXL(m_integrationPlane,x,y,c) =
+                        IntegrationStack::combine(m_rejectionType, stack, k,
+                                                  m_upper, m_lower,
+                                                  scratch.data(), low, high);
+                SUBPXL(m_countPlane,x,y,c) = k ? 1 : 0;
+                tileTotal += k;
+                for (int i = 0 ; i < k ; ++i ) {
+                    if ( stack[i] >= low && stack[i] <= high )
+                        continue;
+                    ++tileRejected;
+                    if ( rejectionMaps ) {
+                        /* the source quantum, in the scale of the frame,
+                         * as the frame path writes it */
+                        size_t source = size_t(p) * frames + i;
+                        Magick::PixelPacket &rej = rejPixels[sources[source]][y * m_w + x];
+                        switch(c) {
+                        case 0: rej.red = sourcePixels[source].red; break;
+                        case 1: rej.green = sourcePixels[source].green; break;
+                        case 2: rej.blue = sourcePixels[source].blue; break;
+                        }
+                    }
+                }
+            }
+        }
+        dfl_critical_section({
+            total += tileTotal;
+            rejectedCount += tileRejected;
+        });
+        advanceProgress();
+    });
+    totalPixels += total;
+    rejected += rejectedCount;
+    if ( aborted() )
+        return false;
+    for (int f = 0 ; f < rejPhotos.count() ; ++f ) {
+        rejCaches[f]->sync();
+        outputPush(1, rejPhotos[f]);
+    }
+    return true;
+}
+
+/**
+ * @brief WorkerIntegration::drizzle integrates the frames by drizzling: each
+ * input pixel is shrunk to a drop of m_pixfrac its size, mapped on the output
+ * and deposited on the output pixels it covers, weighted by the covered area.
+ * A drop is the square of the area of the mapped pixel, centered on the mapped
+ * pixel center. The output is drizzled tile by tile, each tile gathering the
+ * drops of all the frames that fall on it, so no two threads write the same
+ * output pixel
+ */
+bool WorkerIntegration::drizzle(const QVector<QPointF> &reference, long &totalPixels)
+{
+    QVector<std::shared_ptr<TransformView> > views;
+    QVector<FrameExposure> exposures;
+    QVector<qreal> drops;
+    foreach(Photo photo, m_inputs[0]) {
+        if ( photo.getScale() == Photo::NonLinear ) {
+            dflWarning(tr("%0 is non-linear").arg(photo.getIdentity()));
+        }
+        std::shared_ptr<TransformView> view(new TransformView(photo, m_scale, reference));
+        if (view->inError()) {
+            dflError(tr("view in error"));
+            continue;
+        }
+        if (!view->loadPixels()) {
+            dflError(tr("unable to load pixels"));
+            continue;
+        }
+        /* half the side of the drop, from the area of a mapped pixel */
+        qreal ox, oy, ux, uy, vx, vy;
+        view->invMap(0, 0, &ox, &oy);
+        view->invMap(1, 0, &ux, &uy);
+        view->invMap(0, 1, &vx, &vy);
+        qreal area = fabs((ux - ox) * (vy - oy) - (uy - oy) * (vx - ox));
+        views.push_back(view);
+        exposures.push_back(FrameExposure(photo));
+        drops.push_back(m_pixfrac * sqrt(area) / 2);
+    }
+    int frames = views.count();
+    if ( 0 == frames )
+        return true;
+
+    int tilesX = (m_w + DF_DRIZZLE_TILE - 1) / DF_DRIZZLE_TILE;
+    int tiles = tilesX * ((m_h + DF_DRIZZLE_TILE - 1) / DF_DRIZZLE_TILE);
+    dflDebug(tr("Drizzle of %0 frames, %1 tiles, drop size %2").arg(frames).arg(tiles).arg(m_pixfrac));
+    setProgress(0, tiles);
+
+    dfl_block long total = 0;
+    dfl_parallel_for(t, 0, tiles, 1, (), {
+        if ( aborted() )
+            continue;
+        int x0 = (t % tilesX) * DF_DRIZZLE_TILE;
+        int y0 = (t / tilesX) * DF_DRIZZLE_TILE;
+        int w = qMin(DF_DRIZZLE_TILE, m_w - x0);
+        int h = qMin(DF_DRIZZLE_TILE, m_h - y0);
+        std::vector<double> weights(size_t(w) * h, 0.);
+        long tileTotal = 0;
+        for (int f = 0 ; f < frames ; ++f ) {
+            TransformView *view = views[f].get();
+            qreal drop = drops[f];
+            int sw = view->sourceWidth();
+            int sh = view->sourceHeight();
+            /* the input pixels whose drop may fall on the tile */
+            qreal left = sw, top = sh, right = 0, bottom = 0;
+            for (int corner = 0 ; corner < 4 ; ++corner ) {
+                qreal sx, sy;
+                view->map((corner & 1) ? x0 + w + drop : x0 - drop,
+                          (corner & 2) ? y0 + h + drop : y0 - drop,
+                          &sx, &sy);
+                left = qMin(left, sx);
+                right = qMax(right, sx);
+                top = qMin(top, sy);
+                bottom = qMax(bottom, sy);
+            }
+            int i0 = qMax(0, int(floor(left)));
+            int i1 = qMin(sw, int(ceil(right)) + 1);
+            int j0 = qMax(0, int(floor(top)));
+            int j1 = qMin(sh, int(ceil(bottom)) + 1);
+            for (int j = j0 ; j < j1 ; ++j ) {
+                const Magick::PixelPacket *src = view->sourceRow(j);
+                for (int i = i0 ; i < i1 ; ++i ) {
+                    qreal cx, cy;
+                    view->invMap(i + .5, j + .5, &cx, &cy);
+                    qreal l = qMax<qreal>(cx - drop, x0);
+                    qreal r = qMin<qreal>(cx + drop, x0 + w);
+                    qreal tp = qMax<qreal>(cy - drop, y0);
+                    qreal b = qMin<qreal>(cy + drop, y0 + h);
+                    if ( l >= r || tp >= b )
+                        continue;
+                    double rgb[3];
+                    if ( !exposures[f].load(src[i], rgb) )
+                        continue;
+                    /* a drop is counted by the tile of its center only */
+                    if ( cx >= x0 && cx < x0 + w && cy >= y0 && cy < y0 + h )
+                        ++tileTotal;
+                    for (int y = tp ; y < b ; ++y ) {
+                        qreal dy = qMin<qreal>(y + 1, b) - qMax<qreal>(y, tp);
+                        for (int x = l ; x < r ; ++x ) {
+                            qreal a = dy * (qMin<qreal>(x + 1, r) - qMax<qreal>(x, l));
+                            weights[size_t(y - y0) * w + x - x0] += a;
+                            for (int c = 0 ; c < 3 ; ++c )
+                                SUBPXL(m_integrationPlane,x,y,c) += a * rgb[c];
+                        }
+                    }
+                }
+            }
+        }
+        /* the count of a covered pixel is 1 once divided by its weight */
+        for (int y = 0 ; y < h ; ++y ) {
+            for (int x = 0 ; x < w ; ++x ) {
+                double weight = weights[size_t(y) * w + x];
+                if ( weight <= 0 )
+                    continue;
+                for (int c = 0 ; c < 3 ; ++c ) {
+                    SUBPXL(m_integrationPlane,x0+x,y0+y,c) /= weight;
+                    SUBPXL(m_countPlane,x0+x,y0+y,c) = 1;
+                }
+            }
+        }
+        dfl_critical_section({
+            total += tileTotal;
+        });
+        advanceProgress();
+    });
+    totalPixels += total;
+    return !aborted();
+}
+
 void WorkerIntegration::createPlanes(Magick::Image &image)
 {
     m_w = image.columns() * m_scale;
     m_h = image.rows() * m_scale;
     m_integrationPlane = new integration_plane_t[m_w*m_h*3]();
     m_countPlane = new int[m_w*m_h*3]();
-    switch(m_rejectionType) {
+    switch(m_drizzle ? OpIntegration::NoRejection : m_rejectionType) {
     case OpIntegration::MinMax:
         m_minPlane = new integration_plane_t[m_w*m_h*3]();
         m_maxPlane = new integration_plane_t[m_w*m_h*3]();
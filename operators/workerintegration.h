@@ -50,6 +50,9 @@ public:
                       qreal customNormalizationValue,
                       bool outputHDR,
                       qreal scale,
+                      TransformView::Interpolation interpolation,
+                      bool drizzle,
+                      qreal pixfrac,
                       QThread *thread, OpIntegration *op);
     ~WorkerIntegration();
     Photo process(const Photo &, int, int) { throw 0; }
@@ -76,9 +79,15 @@ public:
     qreal m_offX;
     qreal m_offY;
     qreal m_scale;
+    TransformView::Interpolation m_interpolation;
+    bool m_drizzle;
+    qreal m_pixfrac;
 
 private:
     void createPlanes(Magick::Image&);
+    bool integrateStacks(const QVector<QPointF>& reference,
+                         long& totalPixels, long& rejected);
+    bool drizzle(const QVector<QPointF>& reference, long& totalPixels);
 };
 
 #endif // WORKERINTEGRATION_H
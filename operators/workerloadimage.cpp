@@ -53,8 +53,8 @@ void WorkerLoadImage::play()
     QVector<QString>& collection = m_filesCollection;
 
     int s = collection.count();
-    dfl_block int p = 0;
     dfl_block bool failure = false;
+    setProgress(0, s);
 
     dfl_parallel_for(i, 0, s, 1, (), {
         if ( failure || aborted() ) {
@@ -111,10 +111,8 @@ void WorkerLoadImage::play()
             failure = true;
         }
 
-        dfl_critical_section({
-            if ( !failure )
-                emit progress(++p, s);
-        });
+        if ( !failure )
+            advanceProgress();
     });
     if ( failure ) {
         emitFailure();
@@ -60,8 +60,8 @@ void WorkerLoadRaw::play()
 {
     QVector<QString> collection = m_loadraw->getCollection().toVector();
     int s = collection.count();
-    dfl_block int p = 0;
     dfl_block bool failure = false;
+    setProgress(0, s);
 
  dfl_parallel_for(i, 0, s, 1, (), {
         if ( failure || aborted() ) {
@@ -90,9 +90,9 @@ void WorkerLoadRaw::play()
             setTags(collection[i], photo);
             photo.setSequenceNumber(i);
             dfl_critical_section({
-                emit progress(++p, s);
                 outputPush(0, photo);
             });
+            advanceProgress();
         }
         catch (std::exception &e) {
             dflError("%s", e.what());
@@ -85,7 +85,9 @@ public:
       double *ssd = new double[ssd_sz];
       memset(ssd, 0, ssd_sz * sizeof(*ssd));
       dfl_parallel_for(dy, 0, dh, 1, (), {
-          for ( int dx = 0 ; dx < dw ; ++dx )
+          for ( int dx = 0 ; dx < dw ; ++dx ) {
+              if ( DfCancellation::requested() )
+                  break;
               //needle window
               for ( int y = 0 ; y < h ; ++y )
                   for ( int x = 0 ; x < w ; ++x ) {
@@ -93,6 +95,7 @@ public:
                               - double(buffer[y*w+x])/QuantumRange;
                       ssd[dy*dw+dx] += d*d;
                   }
+          }
       });
       delete haystack;
       double min = ssd[0];
@@ -167,6 +170,8 @@ bool WorkerSsdReg::play_onInput(int idx)
         Photo photo = m_inputs[0][i];
         try {
             QPointF off = needle->lookup(this, photo.image());
+            // an interrupted lookup leaves a partial score map
+            if ( aborted() ) continue;
             QString points = QString::number(off.x()) +
                     "," + QString::number(off.y());
             photo.setTag(TAG_POINTS, points);
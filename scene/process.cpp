@@ -150,12 +150,15 @@ Process::Process(ProcessScene *scene, QObject *parent) :
     m_lastMousePosition(),
     m_lastScreenPosition(),
     m_conn(NULL),
-    m_contextMenu(new QMenu)
+    m_contextMenu(scene ? new QMenu : NULL),
+    m_operators()
 {
     reset();
-    connect(m_scene, SIGNAL(contextMenuSignal(QGraphicsSceneContextMenuEvent*)),
-            this, SLOT(contextMenuSignal(QGraphicsSceneContextMenuEvent*)));
-    m_scene->installEventFilter(this);
+    if ( m_scene ) {
+        connect(m_scene, SIGNAL(contextMenuSignal(QGraphicsSceneContextMenuEvent*)),
+                this, SLOT(contextMenuSignal(QGraphicsSceneContextMenuEvent*)));
+        m_scene->installEventFilter(this);
+    }
 
     m_availableOperators.push_back(new OpLoadRaw(this));
     m_availableOperators.push_back(new OpLoadImage(this));
@@ -239,7 +242,8 @@ Process::Process(ProcessScene *scene, QObject *parent) :
     m_availableOperators.push_back(new OpExNihilo(this));
     m_availableOperators.push_back(new OpPassThrough(this));
 
-    addOperatorsToContextMenu();
+    if ( m_contextMenu )
+        addOperatorsToContextMenu();
     addParameterizedOperators();
 }
 
@@ -288,9 +292,13 @@ Process::~Process() {
     foreach(Operator *op, m_availableOperators) {
         delete op;
     }
+    foreach(Operator *op, m_operators) {
+        delete op;
+    }
 
-    disconnect(m_scene, SIGNAL(contextMenuSignal(QGraphicsSceneContextMenuEvent*)),
-            this, SLOT(contextMenuSignal(QGraphicsSceneContextMenuEvent*)));
+    if ( m_scene )
+        disconnect(m_scene, SIGNAL(contextMenuSignal(QGraphicsSceneContextMenuEvent*)),
+                   this, SLOT(contextMenuSignal(QGraphicsSceneContextMenuEvent*)));
     delete m_contextMenu;
 }
 
@@ -346,12 +354,38 @@ void Process::setDirty(bool dirty)
 
 void Process::addOperator(Operator *op)
 {
-    ProcessNode *node = new ProcessNode(m_lastMousePosition,
-                                        op, this);
-    m_scene->addItem(node);
+    if ( m_scene ) {
+        ProcessNode *node = new ProcessNode(m_lastMousePosition,
+                                            op, this);
+        m_scene->addItem(node);
+    }
+    else {
+        m_operators.push_back(op);
+    }
     setDirty(true);
 }
 
+QVector<Operator *> Process::operators() const
+{
+    if ( !m_scene )
+        return m_operators;
+    QVector<Operator*> operators;
+    foreach(QGraphicsItem *item, m_scene->items()) {
+        if ( item->type() == QGraphicsItem::UserType + ProcessScene::UserTypeNode )
+            operators.push_back(dynamic_cast<ProcessNode *>(item)->m_operator);
+    }
+    return operators;
+}
+
+Operator *Process::findOperator(const QString &uuid) const
+{
+    foreach(Operator *op, operators()) {
+        if ( op->uuid() == uuid )
+            return op;
+    }
+    return NULL;
+}
+
 QString Process::projectFile() const
 {
     return m_projectFile;
@@ -398,18 +432,22 @@ void Process::save()
     setDirty(false);
 }
 
-void Process::load(const QString& filename)
+bool Process::load(const QString& filename)
 {
     QDir projectFileDir(QFileInfo(filename).absoluteDir());
     QFile loadFile(filename);
     if (!loadFile.open(QIODevice::ReadOnly))
     {
             dflWarning(tr("Process::load: Couldn't open file %0").arg(filename));
-            return;
+            return false;
     }
     QByteArray data = loadFile.readAll();
     //QJsonDocument doc(QJsonDocument::fromBinaryData(data));
     QJsonDocument doc(QJsonDocument::fromJson(data));
+    if ( !doc.isObject() ) {
+        dflWarning(tr("Process::load: Invalid project file %0").arg(filename));
+        return false;
+    }
     QJsonObject obj = doc.object();
     setProjectFile(filename);
     setProjectName(obj["projectName"].toString());
@@ -438,6 +476,23 @@ void Process::load(const QString& filename)
     }
     foreach(QJsonValue val, obj["connections"].toArray()) {
         QJsonObject obj = val.toObject();
+        if ( !m_scene ) {
+            Operator *outOp = findOperator(obj["outPortUuid"].toString());
+            Operator *inOp = findOperator(obj["inPortUuid"].toString());
+            if ( NULL == outOp || NULL == inOp ) {
+                dflWarning(tr("Process: unknown node in connection"));
+                continue;
+            }
+            int outIdx = obj["outPortIdx"].toInt();
+            int inIdx = obj["inPortIdx"].toInt();
+            if ( outIdx < 0 || outIdx >= outOp->getOutputs().count() ||
+                 inIdx < 0 || inIdx >= inOp->getInputs().count() ) {
+                dflWarning(tr("Process: invalid port in connection"));
+                continue;
+            }
+            Operator::operator_connect(outOp, outIdx, inOp, inIdx);
+            continue;
+        }
         ProcessNode *outNode = findNode(obj["outPortUuid"].toString());
         if ( NULL == outNode ) {
             dflWarning(tr("Process: unknown output node"));
@@ -459,6 +514,7 @@ void Process::load(const QString& filename)
 
 
     setDirty(false);
+    return true;
 }
 
 ProcessNode *Process::findNode(const QString &uuid)
@@ -630,12 +686,20 @@ void Process::reset()
     setNotes("");
     setProjectFile("");
     setBaseDirectory(preferences->baseDir());
-    m_scene->clear();
+    if ( m_scene ) {
+        m_scene->clear();
+    }
+    else {
+        foreach(Operator *op, m_operators)
+            delete op;
+        m_operators.clear();
+    }
     setDirty(true);
 }
 void Process::spawnContextMenu(const QPoint& pos)
 {
-    m_contextMenu->exec(pos);
+    if ( m_contextMenu )
+        m_contextMenu->exec(pos);
 }
 
 void Process::contextMenuSignal(QGraphicsSceneContextMenuEvent *event)
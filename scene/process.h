@@ -61,6 +61,11 @@ public:
     static QString uuid();
 
 
+    /**
+     * @brief Process
+     * @param scene the scene showing the nodes, or NULL for a headless
+     * process that only keeps the operator graph
+     */
     explicit Process(ProcessScene *scene, QObject *parent = 0);
     ~Process();
 
@@ -78,13 +83,15 @@ public:
 
     void reset();
     void save();
-    void load(const QString& filename);
+    bool load(const QString& filename);
 
 
     bool dirty() const;
     void setDirty(bool dirty);
 
     void addOperator(Operator *op);
+    QVector<Operator*> operators() const;
+    Operator *findOperator(const QString& uuid) const;
     void spawnContextMenu(const QPoint& pos);
 
     ProcessNode *findNode(const QString& uuid);
@@ -112,6 +119,7 @@ private:
     QPoint m_lastScreenPosition;
     ProcessConnection *m_conn;
     QMenu *m_contextMenu;
+    QVector<Operator*> m_operators;
 
 
     QGraphicsItem* findItem(const QPointF &pos, int type);
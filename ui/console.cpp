@@ -29,25 +29,127 @@
  *
  */
 #include <cstdio>
+#include <algorithm>
 #include "console.h"
 #include "ui_console.h"
 #include <QDateTime>
+#include <QTimer>
+#include <QMutex>
+#include <QThreadStorage>
 #include "darkflow.h"
 
+#define DF_LOG_RING_SIZE 1024
+#define DF_LOG_DRAIN_INTERVAL 50 /* ms */
+
 Console *console = NULL;
 
+std::atomic<int> Console::s_level(Console::Info);
+std::atomic<int> Console::s_trapLevel(Console::LastLevel);
+
+struct LogRecord {
+    Console::Level level;
+    qint64 time;
+    QString who;
+    QString text;
+};
+
+/*
+ * Lock free, one producer (the thread the ring belongs to) and one
+ * consumer (the console, in the GUI thread). The slots from tail to head
+ * belong to the consumer, the others to the producer
+ */
+class LogRing {
+public:
+    LogRing() : m_orphan(false), m_head(0), m_tail(0) {}
+    bool push(const LogRecord& record) {
+        quint64 head = m_head.load(std::memory_order_relaxed);
+        if ( head - m_tail.load(std::memory_order_acquire) >= DF_LOG_RING_SIZE )
+            return false;
+        m_slots[head % DF_LOG_RING_SIZE] = record;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    void drain(QVector<LogRecord>& records) {
+        quint64 tail = m_tail.load(std::memory_order_relaxed);
+        quint64 head = m_head.load(std::memory_order_acquire);
+        for ( ; tail != head ; ++tail ) {
+            LogRecord& slot = m_slots[tail % DF_LOG_RING_SIZE];
+            records.push_back(slot);
+            slot.who.clear();
+            slot.text.clear();
+        }
+        m_tail.store(tail, std::memory_order_release);
+    }
+    bool isEmpty() const {
+        return m_head.load(std::memory_order_acquire) ==
+                m_tail.load(std::memory_order_acquire);
+    }
+    /* set when the thread is gone, the ring may then be reused */
+    std::atomic<bool> m_orphan;
+private:
+    std::atomic<quint64> m_head;
+    std::atomic<quint64> m_tail;
+    LogRecord m_slots[DF_LOG_RING_SIZE];
+};
+
+class LogRingHandle {
+public:
+    explicit LogRingHandle(LogRing *ring) : m_ring(ring) {}
+    ~LogRingHandle() { m_ring->m_orphan.store(true, std::memory_order_release); }
+    LogRing *m_ring;
+};
+
+static QMutex s_ringsMutex;
+static QVector<LogRing*> s_rings;
+static QThreadStorage<LogRingHandle*> t_ring;
+static std::atomic<int> s_dropped(0);
+
+static LogRing *threadRing()
+{
+    if ( !t_ring.hasLocalData() ) {
+        QMutexLocker lock(&s_ringsMutex);
+        LogRing *ring = NULL;
+        foreach(LogRing *r, s_rings) {
+            if ( r->m_orphan.load(std::memory_order_acquire) && r->isEmpty() ) {
+                r->m_orphan.store(false);
+                ring = r;
+                break;
+            }
+        }
+        if ( !ring ) {
+            ring = new LogRing;
+            s_rings.push_back(ring);
+        }
+        t_ring.setLocalData(new LogRingHandle(ring));
+    }
+    return t_ring.localData()->m_ring;
+}
+
+static void post(Console::Level level, const QString& who, const QString& text)
+{
+    LogRecord record = { level, QDateTime::currentMSecsSinceEpoch(), who, text };
+    if ( !threadRing()->push(record) )
+        ++s_dropped;
+}
+
+static bool olderThan(const LogRecord& a, const LogRecord& b)
+{
+    return a.time < b.time;
+}
+
 Console::Console(QWidget *parent) :
     QMainWindow(parent),
-    m_level(Info),
     m_raiseLevel(Error),
-    m_trapLevel(LastLevel),
+    m_headless(false),
+    m_drainTimer(new QTimer(this)),
     ui(new Ui::Console)
 {
     ui->setupUi(this);
     setWindowIcon(QIcon(DF_ICON));
     setWindowFlags(Qt::Tool);
     ui->textEdit->setStyleSheet("QTextEdit { background-color: black }");
-    connect(this, SIGNAL(message(Level, QString)), this, SLOT(recvMessage(Level, QString)), Qt::QueuedConnection);
+    connect(m_drainTimer, SIGNAL(timeout()), this, SLOT(drain()));
+    m_drainTimer->start(DF_LOG_DRAIN_INTERVAL);
 }
 
 Console::~Console()
@@ -55,22 +157,30 @@ Console::~Console()
     delete ui;
 }
 
-void Console::init()
+void Console::init(bool headless)
 {
-    qRegisterMetaType<Level>("Level");
     console = new Console();
+    console->m_headless = headless;
     dflInfo(tr("Darkflow Started!"));
 }
 
 void Console::fini()
 {
+    console->drain();
     console->hide();
     delete console;
     console = NULL;
 }
 
+bool Console::isHeadless()
+{
+    return console && console->m_headless;
+}
+
 void Console::show()
 {
+    if ( console->m_headless )
+        return;
     console->QMainWindow::show();
     console->raise();
 }
@@ -82,17 +192,17 @@ void Console::close()
 
 Console::Level Console::getLevel()
 {
-    return console->m_level;
+    return Level(s_level.load(std::memory_order_relaxed));
 }
 
 void Console::setLevel(Console::Level level)
 {
-    console->m_level = level;
+    s_level.store(level);
 }
 
 void Console::setTrapLevel(Console::Level level)
 {
-    console->m_trapLevel = level;
+    s_trapLevel.store(level);
 }
 
 void Console::setRaiseLevel(Console::Level level)
@@ -102,43 +212,96 @@ void Console::setRaiseLevel(Console::Level level)
 
 void Console::trap(Console::Level level)
 {
-    if ( level >= console->m_trapLevel )
+    if ( level >= s_trapLevel.load(std::memory_order_relaxed) )
         DF_TRAP();
 }
 
-void Console::recvMessage(Console::Level level, QString message)
+void Console::flush()
+{
+    if ( console )
+        console->drain();
+}
+
+/**
+ * @brief Console::drain collects the messages of all the threads and
+ * delivers them in one batch
+ */
+void Console::drain()
+{
+    QVector<LogRing*> rings;
+    {
+        QMutexLocker lock(&s_ringsMutex);
+        rings = s_rings;
+    }
+    QVector<LogRecord> records;
+    foreach(LogRing *ring, rings)
+        ring->drain(records);
+    int dropped = s_dropped.exchange(0);
+    if ( dropped ) {
+        LogRecord record = { Warning, QDateTime::currentMSecsSinceEpoch(), QString(),
+                             tr("%0 messages dropped, the log was too busy").arg(dropped) };
+        records.push_back(record);
+    }
+    if ( records.isEmpty() )
+        return;
+    std::stable_sort(records.begin(), records.end(), olderThan);
+    deliver(records);
+}
+
+void Console::deliver(const QVector<LogRecord> &records)
 {
-    if ( level < m_level )
+    static const char *levels[] = { "D", "I", "W", "E", "C" };
+    if ( m_headless ) {
+        foreach(const LogRecord& r, records) {
+            QString message = r.who.isEmpty() ? r.text : r.who + ": " + r.text;
+            fprintf(stderr, "%s [%s] %s\n",
+                    QDateTime::fromMSecsSinceEpoch(r.time).toString("yyyy/MM/dd-HH:mm:ss").toLocal8Bit().constData(),
+                    r.level < LastLevel ? levels[r.level] : "?",
+                    message.toLocal8Bit().constData());
+        }
         return;
-    ui->textEdit->setTextBackgroundColor(Qt::black);
-    switch(level) {
-    case Console::Debug:
-        ui->textEdit->setTextColor(Qt::darkYellow);
-        break;
-    case Console::Info:
-        ui->textEdit->setTextColor(Qt::green);
-        break;
-    case Console::Warning:
-        ui->textEdit->setTextColor(Qt::magenta);
-        break;
-    case Console::Error:
-        ui->textEdit->setTextColor(Qt::red);
-        message = message;
-        break;
-    default:
-        message = tr("Unknown LogLevel!: %0").arg(message);
-        // Falls through
-    case Console::Critical:
-        ui->textEdit->setTextBackgroundColor(Qt::red);
-        ui->textEdit->setTextColor(Qt::white);
-        show();
-        break;
     }
-    if ( level >= m_raiseLevel ) {
+    QStringList lines;
+    bool popUp = false;
+    foreach(const LogRecord& r, records) {
+        QString message = r.who.isEmpty() ? r.text : r.who + ": " + r.text;
+        QColor foreground;
+        QColor background = Qt::black;
+        switch(r.level) {
+        case Console::Debug:
+            foreground = Qt::darkYellow;
+            break;
+        case Console::Info:
+            foreground = Qt::green;
+            break;
+        case Console::Warning:
+            foreground = Qt::magenta;
+            break;
+        case Console::Error:
+            foreground = Qt::red;
+            break;
+        default:
+            message = tr("Unknown LogLevel!: %0").arg(message);
+            // Falls through
+        case Console::Critical:
+            foreground = Qt::white;
+            background = Qt::red;
+            popUp = true;
+            break;
+        }
+        if ( r.level >= m_raiseLevel )
+            popUp = true;
+        lines.push_back(QString("<span style=\"color:%0; background-color:%1\">%2: %3</span>")
+                        .arg(foreground.name())
+                        .arg(background.name())
+                        .arg(QDateTime::fromMSecsSinceEpoch(r.time).toString("yyyy/MM/dd-HH:mm:ss"))
+                        .arg(message.toHtmlEscaped()));
+    }
+    if ( popUp ) {
         show();
         raise();
     }
-    ui->textEdit->append(QDateTime::currentDateTime().toString("yyyy/MM/dd-HH:mm:ss")+": "+message);
+    ui->textEdit->append(lines.join("<br>"));
 }
 
 static void message(Console::Level level, const char *fmt, va_list ap)
@@ -150,7 +313,7 @@ static void message(Console::Level level, const char *fmt, va_list ap)
     int ret;
     ret = vasprintf(&msg, fmt, ap);
     if ( ret < 0 ) return;
-    emit console->message(level, msg);
+    post(level, QString(), QString::fromUtf8(msg));
     free(msg);
 }
 
@@ -203,7 +366,13 @@ void dflCritical(const char* fmt, ...)
 void dflMessage(Console::Level level, const QString& msg) {
     Console::trap(level);
     if (level >= Console::getLevel())
-        emit console->message(level, msg);
+        post(level, QString(), msg);
+}
+
+void dflMessage(Console::Level level, const QString& who, const QString& msg) {
+    Console::trap(level);
+    if (level >= Console::getLevel())
+        post(level, who, msg);
 }
 
 void dflDebug(const QString &msg)
@@ -33,10 +33,13 @@
 
 #include "ports.h"
 #include <QMainWindow>
+#include <atomic>
 
 namespace Ui {
 class Console;
 }
+class QTimer;
+struct LogRecord;
 
 class Console : public QMainWindow
 {
@@ -50,7 +53,12 @@ public:
         Critical,
         LastLevel
     } Level;
-    static void init();
+    /**
+     * @brief init
+     * @param headless messages go to stderr and the console never shows up
+     */
+    static void init(bool headless = false);
+    static bool isHeadless();
     static void fini();
     static void show();
     static void close();
@@ -59,17 +67,30 @@ public:
     static void setTrapLevel(Level level);
     static void setRaiseLevel(Level level);
     static void trap(Level level);
+    /**
+     * @brief isEnabled
+     * @return true if a message of that level is logged or trapped,
+     * to be checked before the message is built
+     */
+    static bool isEnabled(Level level) {
+        return level >= s_level.load(std::memory_order_relaxed) ||
+               level >= s_trapLevel.load(std::memory_order_relaxed);
+    }
+    /**
+     * @brief flush delivers the pending messages now, from the GUI thread
+     */
+    static void flush();
 
 private slots:
-    void recvMessage(Level level, QString message);
-
-signals:
-    void message(Level level, QString message);
+    void drain();
 
 private:
-    Level m_level;
+    static std::atomic<int> s_level;
+    static std::atomic<int> s_trapLevel;
     Level m_raiseLevel;
-    Level m_trapLevel;
+    bool m_headless;
+    QTimer *m_drainTimer;
+    void deliver(const QVector<LogRecord>& records);
     explicit Console(QWidget *parent = 0);
     Ui::Console *ui;
     ~Console();
@@ -85,6 +106,10 @@ void dflError(const char* fmt, ...) DF_PRINTF_FORMAT(1,2);
 void dflCritical(const char* fmt, ...) DF_PRINTF_FORMAT(1,2);
 
 void dflMessage(Console::Level, const QString& msg);
+/**
+ * @brief dflMessage who and msg are only joined when the message is shown
+ */
+void dflMessage(Console::Level, const QString& who, const QString& msg);
 void dflDebug(const QString& msg);
 void dflInfo(const QString& msg);
 void dflWarning(const QString& msg);
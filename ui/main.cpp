@@ -30,6 +30,7 @@
  */
 #include "preferences.h"
 #include "mainwindow.h"
+#include "profiler.h"
 #include <QApplication>
 #include <QTranslator>
 #include <QPalette>
@@ -50,11 +51,19 @@ int main(int argc, char *argv[])
     translator.load(QString(":/l10n/darkflow_") + locale);
     a.installTranslator(&translator);
 
+    /* DARKFLOW_TRACE=file records a Chrome trace of the session */
+    QString trace = QString::fromLocal8Bit(qgetenv("DARKFLOW_TRACE"));
+    if ( !trace.isEmpty() )
+        Profiler::instance()->setEnabled(true);
+
     dflMainWindow = new MainWindow();
     if (argc == 2)
         dflMainWindow->load(argv[1]);
 
     dflMainWindow->show();
 
-    return a.exec();
+    int ret = a.exec();
+    if ( !trace.isEmpty() )
+        Profiler::instance()->writeTrace(trace);
+    return ret;
 }
@@ -35,15 +35,16 @@
 #include <QDir>
 #include <QAbstractButton>
 #include <QFileDialog>
-#include <QSemaphore>
-#include <QMutex>
-#include <QMutexLocker>
 #include <QMessageBox>
 
 #include "preferences.h"
 #include "ui_preferences.h"
 #include "console.h"
 #include "operatorworker.h"
+#include "scheduler.h"
+#include "resultstore.h"
+#include "resultcache.h"
+#include "threadbudget.h"
 #include "darkflow.h"
 #include "mainwindow.h"
 #include <Magick++.h>
@@ -51,6 +52,9 @@
 #ifdef DFL_USE_GCD
 #include <thread>
 #endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 QPalette dflOriginalPalette;
 
 #ifndef QuantumRange
@@ -82,7 +86,8 @@ static int dfl_max_threads() {
     return n;
 #endif
 }
-#define N_WORKERS 4
+#define DF_DEFAULT_WORKERS 1
+#define DF_DEFAULT_CACHE_CEILING (qint64(20)<<30)
 #define LAB_SEL_SIZE 256
 
 Preferences *preferences = NULL;
@@ -101,11 +106,15 @@ Preferences::Preferences(QWidget *parent) :
       #endif
       ),
   m_defaultThreads(0),
-  m_sem(new QSemaphore(N_WORKERS)),
-  m_mutex(new QMutex),
-  m_currentMaxWorkers(N_WORKERS),
-  m_scheduledMaxWorkers(1),
+  m_scheduler(new Scheduler(DF_DEFAULT_WORKERS, dfl_physical_memory()/2)),
+  m_scheduledMaxWorkers(DF_DEFAULT_WORKERS),
+  m_memoryBudget(dfl_physical_memory()/2),
+  m_resultsCeiling(0),
   m_OpenMPThreads(dfl_max_threads()),
+  m_streaming(true),
+  m_pipelining(true),
+  m_resultCache(false),
+  m_resultCacheCeiling(DF_DEFAULT_CACHE_CEILING),
   m_currentTarget(sRGB),
   m_incompatibleAction(Error),
   m_labSelectionSize(LAB_SEL_SIZE),
@@ -117,9 +126,17 @@ Preferences::Preferences(QWidget *parent) :
     setWindowFlags(Qt::Tool);
     Magick::InitializeMagick("darkflow");
     getDefaultMagickResources();
+    ThreadBudget::instance()->setThreads(m_OpenMPThreads);
+#ifdef _OPENMP
+    /* nested loops only get the threads left by the enclosing ones */
+    omp_set_max_active_levels(2);
+#endif
 
     ui->defaultDflThreads->setText(QString::number(m_OpenMPThreads));
     ui->defaultDflWorkers->setText(QString::number(m_scheduledMaxWorkers));
+    ui->defaultDflMemory->setText(QString::number(double(m_memoryBudget)/(1<<30), 'f', 1));
+    ui->defaultDflResults->setText(QString::number(double(m_resultsCeiling)/(1<<30), 'f', 1));
+    ui->defaultDflResultCache->setText(QString::number(double(m_resultCacheCeiling)/(1<<30), 'f', 1));
 
     bool loaded = load(false);
 
@@ -134,6 +151,9 @@ Preferences::Preferences(QWidget *parent) :
 #endif
         ui->valueDflThreads->setText(QString::number(m_OpenMPThreads));
         ui->valueDflWorkers->setText(QString::number(m_scheduledMaxWorkers));
+        ui->valueDflMemory->setText(QString::number(double(m_memoryBudget)/(1<<30), 'f', 1));
+        ui->valueDflResults->setText(QString::number(double(m_resultsCeiling)/(1<<30), 'f', 1));
+        ui->valueDflResultCache->setText(QString::number(double(m_resultCacheCeiling)/(1<<30), 'f', 1));
 
         ui->valueTmpDir->setText(QStandardPaths::writableLocation(QStandardPaths::TempLocation));
         ui->valueBaseDir->setText(QStandardPaths::writableLocation(QStandardPaths::PicturesLocation));
@@ -159,15 +179,17 @@ Preferences::Preferences(QWidget *parent) :
        QString msg = e.what();
        msg += "\n";
        msg += getenv("MAGICK_CONFIGURE_PATH");
-       QMessageBox::warning(this, "Preliminary ImageMagick Check failed",
-                            msg);
+       if ( Console::isHeadless() )
+           dflCritical(tr("Preliminary ImageMagick Check failed: %0").arg(msg));
+       else
+           QMessageBox::warning(this, "Preliminary ImageMagick Check failed",
+                                msg);
     }
 }
 
 Preferences::~Preferences()
 {
-    delete m_mutex;
-    delete m_sem;
+    delete m_scheduler;
     delete ui;
 }
 
@@ -176,42 +198,19 @@ QString Preferences::baseDir()
     return ui->valueBaseDir->text();
 }
 
-bool Preferences::acquireWorker(OperatorWorker *worker)
+QString Preferences::tmpDir()
 {
-    bool success;
-    do {
-        int toClaim = 1;
-        int currentMaxWorkers = m_currentMaxWorkers;
-        {
-            QMutexLocker lock(m_mutex);
-            if ( m_currentMaxWorkers > m_scheduledMaxWorkers ) {
-                toClaim += m_currentMaxWorkers - m_scheduledMaxWorkers;
-                m_currentMaxWorkers = m_scheduledMaxWorkers;
-            }
-        }
-        success = m_sem->tryAcquire(toClaim, 50);
-        if ( !success) {
-            QMutexLocker lock(m_mutex);
-            m_currentMaxWorkers = currentMaxWorkers;
-            if ( worker->aborted())
-                break;
-        }
-    }
-    while (!success);
-    return success;
+    return ui->valueTmpDir->text();
 }
 
-void Preferences::releaseWorker()
+bool Preferences::acquireWorker(OperatorWorker *worker, int priority, qint64 footprint)
 {
-    int toRelease = 1;
-    {
-        QMutexLocker lock(m_mutex);
-        if ( m_currentMaxWorkers < m_scheduledMaxWorkers ) {
-            toRelease += m_scheduledMaxWorkers - m_currentMaxWorkers;
-            m_currentMaxWorkers = m_scheduledMaxWorkers;
-        }
-    }
-    m_sem->release(toRelease);
+    return m_scheduler->acquire(worker, priority, footprint);
+}
+
+void Preferences::releaseWorker(OperatorWorker *worker)
+{
+    m_scheduler->release(worker);
 }
 
 void Preferences::getDefaultMagickResources()
@@ -257,6 +256,10 @@ void Preferences::setMagickResources()
     u_int64_t currentMap     = ui->valueMap->text().toDouble()*div;
     u_int64_t currentDisk    = ui->valueDisk->text().toDouble()*div;
     u_int64_t currentThreads = ui->valueThreads->text().toDouble();
+    /* ImageMagick teams run inside workers, next to each other */
+    u_int64_t workerShare = qMax(1, m_OpenMPThreads / qMax(1, m_scheduledMaxWorkers));
+    if ( currentThreads == 0 || currentThreads > workerShare )
+        currentThreads = workerShare;
 
 #if defined(ANDROID)
     if (currentDisk == 0)
@@ -300,13 +303,27 @@ bool Preferences::load(bool create)
     if ( dflThreads > 1024 )
         dflThreads = 1024;
     m_OpenMPThreads = dflThreads;
+    ThreadBudget::instance()->setThreads(m_OpenMPThreads);
 
-    {
-        QMutexLocker lock(m_mutex);
-        m_scheduledMaxWorkers = dflWorkers;
-    }
+    m_scheduledMaxWorkers = dflWorkers;
+    m_scheduler->setMaxWorkers(dflWorkers);
     ui->valueDflThreads->setText(QString::number(m_OpenMPThreads));
     ui->valueDflWorkers->setText(QString::number(dflWorkers));
+    m_memoryBudget = resources["darkflowMemory"].toDouble(dfl_physical_memory()/2);
+    m_scheduler->setMemoryBudget(m_memoryBudget);
+    ui->valueDflMemory->setText(QString::number(double(m_memoryBudget)/(1<<30), 'f', 1));
+    m_resultsCeiling = resources["darkflowResults"].toDouble(0);
+    ResultStore::instance()->setCeiling(m_resultsCeiling);
+    ui->valueDflResults->setText(QString::number(double(m_resultsCeiling)/(1<<30), 'f', 1));
+    m_streaming = resources["streaming"].toBool(true);
+    ui->checkBoxDflStreaming->setChecked(m_streaming);
+    m_pipelining = resources["pipelining"].toBool(true);
+    ui->checkBoxDflPipelining->setChecked(m_pipelining);
+    m_resultCache = resources["resultCache"].toBool(false);
+    ui->checkBoxDflResultCache->setChecked(m_resultCache);
+    m_resultCacheCeiling = resources["resultCacheCeiling"].toDouble(DF_DEFAULT_CACHE_CEILING);
+    ResultCache::setCeiling(m_resultCacheCeiling);
+    ui->valueDflResultCache->setText(QString::number(double(m_resultCacheCeiling)/(1<<30), 'f', 1));
 
     int64_t area = resources["area"].toDouble();
     int64_t memory = resources["memory"].toDouble();
@@ -397,7 +414,25 @@ void Preferences::save()
     if ( dflWorkers < 1 )
         dflWorkers = 1;
     resources["darkflowWorkers"] = dflWorkers;
+    qint64 dflMemory = ui->valueDflMemory->text().toDouble()*mul;
+    if ( dflMemory < 0 )
+        dflMemory = 0;
+    resources["darkflowMemory"] = dflMemory;
+    qint64 dflResults = ui->valueDflResults->text().toDouble()*mul;
+    if ( dflResults < 0 )
+        dflResults = 0;
+    resources["darkflowResults"] = dflResults;
     resources["darkflowThreads"] = dflThreads;
+    m_streaming = ui->checkBoxDflStreaming->isChecked();
+    resources["streaming"] = m_streaming;
+    m_pipelining = ui->checkBoxDflPipelining->isChecked();
+    resources["pipelining"] = m_pipelining;
+    m_resultCache = ui->checkBoxDflResultCache->isChecked();
+    resources["resultCache"] = m_resultCache;
+    qint64 dflResultCache = ui->valueDflResultCache->text().toDouble()*mul;
+    if ( dflResultCache < 0 )
+        dflResultCache = 0;
+    resources["resultCacheCeiling"] = dflResultCache;
 
     m_currentTarget = TransformTarget(ui->comboTransformTarget->currentIndex());
     pixels["transformTarget"] = m_currentTarget;
@@ -622,6 +657,21 @@ int Preferences::getNumThreads() const
     return m_OpenMPThreads;
 }
 
+bool Preferences::getStreaming() const
+{
+    return m_streaming;
+}
+
+bool Preferences::getPipelining() const
+{
+    return m_pipelining;
+}
+
+bool Preferences::getResultCache() const
+{
+    return m_resultCache;
+}
+
 int Preferences::getMagickNumThreads() const
 {
     return Magick::ResourceLimits::thread();
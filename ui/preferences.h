@@ -38,9 +38,8 @@ namespace Ui {
 class Preferences;
 }
 class QAbstractButton;
-class QSemaphore;
-class QMutex;
 class OperatorWorker;
+class Scheduler;
 class QFont;
 
 class Preferences : public QDialog
@@ -64,13 +63,17 @@ public:
     ~Preferences();
 
     QString baseDir();
+    QString tmpDir();
 
-    bool acquireWorker(OperatorWorker *worker);
-    void releaseWorker();
+    bool acquireWorker(OperatorWorker *worker, int priority, qint64 footprint);
+    void releaseWorker(OperatorWorker *worker);
 
     TransformTarget getCurrentTarget() const;
     IncompatibleAction getIncompatibleAction() const;
     int getNumThreads() const;
+    bool getStreaming() const;
+    bool getPipelining() const;
+    bool getResultCache() const;
     int getMagickNumThreads() const;
     int getLabSelectionSize() const;
     static QString getAppConfigLocation();
@@ -104,11 +107,15 @@ private:
     u_int64_t m_defaultMap;
     u_int64_t m_defaultDisk;
     u_int64_t m_defaultThreads;
-    QSemaphore *m_sem;
-    QMutex *m_mutex;
-    u_int64_t m_currentMaxWorkers;
+    Scheduler *m_scheduler;
     u_int64_t m_scheduledMaxWorkers;
+    u_int64_t m_memoryBudget;
+    u_int64_t m_resultsCeiling;
     u_int64_t m_OpenMPThreads;
+    bool m_streaming;
+    bool m_pipelining;
+    bool m_resultCache;
+    u_int64_t m_resultCacheCeiling;
     TransformTarget m_currentTarget;
     IncompatibleAction m_incompatibleAction;
     int m_labSelectionSize;
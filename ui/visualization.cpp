@@ -642,7 +642,7 @@ void Visualization::updateTreeviewPhotos()
         int idx = 0;
         foreach(OperatorOutput *source, input->sources()) {
             QTreeWidgetItem *tree_source = new TreeOutputItem(source, idx, TreeOutputItem::Source, tree_input);
-            foreach(Photo photo, source->m_result) {
+            foreach(Photo photo, source->getResult()) {
                 if ( !photo.isComplete() )
                     dflCritical(tr("Visualization: source photo is not complete"));
                 QString identity = photo.getIdentity();
@@ -685,7 +685,7 @@ void Visualization::updateTreeviewPhotos()
                                                           : TreeOutputItem::DisabledSink,
                                                           tree_outputs);
         if (m_operator->m_outputStatus[idx] == Operator::OutputEnabled) {
-            foreach(const Photo& photo, output->m_result) {
+            foreach(const Photo& photo, output->getResult()) {
                 if ( !photo.isComplete() )
                     dflCritical(tr("Visualization: output photo is not complete"));
                 TreePhotoItem *item = new TreePhotoItem(photo, TreePhotoItem::Output, tree_output);